@@ -392,6 +392,14 @@ void DsaController::writeDefaultConditions()
   conditionJson.insert(AlertConstants::CONDITION_TARGET, "1");
   allConditionsJson.append(conditionJson);
   m_dsaSettings.insert(AlertConstants::ALERT_CONDITIONS_PROPERTYNAME, allConditionsJson.toVariantList());
+
+  // evaluate alerts 4 times per second (20 for critical alerts), spending no more than 8 ms per tick
+  QJsonObject evaluationJson;
+  evaluationJson.insert(AlertConstants::EVALUATION_RATE, 4);
+  evaluationJson.insert(AlertConstants::EVALUATION_CRITICAL_RATE, 20);
+  evaluationJson.insert(AlertConstants::EVALUATION_TICK_BUDGET, 8);
+  evaluationJson.insert(AlertConstants::EVALUATION_CONCURRENT, false);
+  m_dsaSettings.insert(AlertConstants::ALERT_EVALUATION_PROPERTYNAME, evaluationJson.toVariantMap());
 }
 
 /*! \brief internal
@@ -20,15 +20,23 @@
 
 #include "GeometryQuadtree.h"
 #include "GeoElementUtils.h"
+#include "GeodesicUtils.h"
+#include "PreparedPolygon.h"
+#include "ProjectionUtils.h"
 
 // C++ API headers
 #include "Envelope.h"
 #include "GeoElement.h"
-#include "GeometryEngine.h"
 #include "Point.h"
 
 // Qt headers
-#include <QSet>
+#include <QTimer>
+#include <QVarLengthArray>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -36,36 +44,119 @@ namespace Dsa {
 
 struct GeometryQuadtree::QuadTree
 {
-  explicit QuadTree(int level, double xMin, double xMax, double yMin, double yMax);
-  ~QuadTree();
+  // the number of entries a leaf node can hold before it is split
+  static constexpr int LeafCapacity = 8;
+
+  // the minimum size of the root node, in decimal degrees
+  static constexpr double MinimumRootSize = 0.01;
+
+  enum Quadrant
+  {
+    TopLeft = 0,
+    TopRight,
+    BottomLeft,
+    BottomRight
+  };
+
+  struct LeafEntry
+  {
+    int id = -1;
+    Bounds bounds;
+  };
+
+  enum class SearchItemType
+  {
+    Node,
+    Entry,
+    Result
+  };
+
+  struct SearchItem
+  {
+    double distance = 0.0;
+    int index = -1;
+    SearchItemType type = SearchItemType::Node;
+  };
+
+  struct SearchResult
+  {
+    int id = -1;
+    double distance = 0.0;
+  };
+
+  struct Node
+  {
+    Bounds bounds;
+    int level = 0;
+    int children[4] = {-1, -1, -1, -1};
+    bool leaf = true;
+    QVarLengthArray<LeafEntry, LeafCapacity> entries;
+  };
+
+  explicit QuadTree(const Bounds& rootBounds, int maxLevels);
+
+  bool isValid() const;
+  bool contains(const Bounds& bounds) const;
+
+  void insert(int id, const Bounds& bounds);
+  void remove(int id, const Bounds& bounds);
+  void grow(const Bounds& bounds);
+
+  void intersectingIds(const Bounds& bounds, QVector<int>& results) const;
+
+  template <typename EntryDistance>
+  void nearest(double lon, double lat, int count, double maxDistance,
+               EntryDistance&& entryDistance, QVector<SearchResult>& results) const;
+
+  static bool intersects(const Bounds& a, const Bounds& b);
+  static Bounds padded(const Bounds& bounds);
+
+private:
+  int allocateNode(const Bounds& bounds, int level);
+  void releaseNode(int nodeIndex);
+  Bounds quadrantBounds(int nodeIndex, int quadrant) const;
+  void insertInto(int nodeIndex, const LeafEntry& entry);
+  bool removeFrom(int nodeIndex, int id, const Bounds& bounds);
+  void split(int nodeIndex);
+  void collectIds(int nodeIndex, const Bounds& bounds, QVector<int>& results) const;
+
+  int m_maxLevels = 0;
+  int m_root = -1;
+  std::vector<Node> m_nodes;
+  std::vector<int> m_freeNodes;
+  mutable std::vector<SearchItem> m_searchQueue;
+};
+
+// a read-only R-tree, bulk-loaded with Sort-Tile-Recursive, for elements which are not changing
+struct GeometryQuadtree::PackedRTree
+{
+  // the maximum number of children of each node
+  static constexpr int NodeCapacity = 16;
 
-  QuadTree* createTopLeft(int maxLevels);
-  QuadTree* createTopRight(int maxLevels);
-  QuadTree* createBottomLeft(int maxLevels);
-  QuadTree* createBottomRight(int maxLevels);
+  // an entry (an element) or a node. The entries are stored first, followed by each level of nodes
+  struct PackedNode
+  {
+    Bounds bounds;
+    int first = -1; // the index of the first child of a node, or the id of the element for an entry
+    int count = 0; // the number of children of a node
+  };
 
-  bool assign(const Envelope& extent, int geomId, int maxLevels);
-  void prune();
+  explicit PackedRTree(const QVector<QuadTree::LeafEntry>& entries);
 
-  QSet<int> intersectingIds(const Envelope& extent) const;
-  QSet<int> intersectingIds(const Point& location) const;
+  void intersectingIds(const Bounds& bounds, QVector<int>& results) const;
 
-  bool contains(const Envelope& extent) const;
-  bool intersects(const Envelope& extent) const;
-  bool intersects(const Point& location) const;
+  template <typename EntryDistance>
+  void nearest(double lon, double lat, int count, double maxDistance,
+               EntryDistance&& entryDistance, QVector<QuadTree::SearchResult>& results) const;
 
-  void removeId(int geomId);
+private:
+  void sortTileRecursive(int begin, int end);
 
-  int m_level = 0;
-  double m_xMin = 0.0;
-  double m_xMax = 0.0;
-  double m_yMin = 0.0;
-  double m_yMax = 0.0;
-  QuadTree* m_tl = nullptr; // top left
-  QuadTree* m_tr = nullptr; // top right
-  QuadTree* m_bl = nullptr; // bottom left
-  QuadTree* m_br = nullptr; // bottom right
-  QSet<int> m_geometryIds;
+  std::vector<PackedNode> m_nodes;
+  int m_entryCount = 0;
+  int m_root = -1;
+  mutable std::vector<int> m_stack;
+  mutable std::vector<QuadTree::SearchItem> m_searchQueue;
 };
 
 /*!
@@ -77,6 +168,33 @@ struct GeometryQuadtree::QuadTree
 
   The tree then allows geometric tests for candidate intersections against
   query geometries.
+
+  Nodes are held in a single contiguous pool and refer to their children by index.
+  Element ids (and their WGS84 bounds) are only stored in leaf nodes, which are
+  split once they hold more than a small number of entries.
+
+  The WGS84 geometry and bounds of each element are cached when it is added or changed,
+  so queries do not need to project any element geometry. \l visitCandidates provides
+  access to the cached data without collecting it into a container. \l visitPolygonCandidates
+  provides each polygon as a \l PreparedPolygon, which is created when it is first needed and
+  kept until the geometry of the element changes.
+
+  Changes to element geometry are coalesced: changed elements are marked as dirty and are
+  re-indexed together, once per event-loop turn, with a single \l treeChanged signal. The
+  \l elementsChanged signal reports the bounds which the changed elements had before and after the
+  change, so that users of the tree can limit their response to those areas.
+  Any pending changes are applied before the tree is queried, so results are always up to date.
+
+  As well as candidate intersections, the tree can return the elements which are nearest to a
+  location (\l nearestNeighbours) or within a distance of it (\l withinDistance). Distances are
+  measured in meters using \l GeodesicUtils, optionally in a local frame for short searches.
+
+  The quadtree suits elements which change, but stores an element in every leaf it overlaps and
+  its cells do not fit the elements. If a \l staticIndexDelay is set, then once the elements have
+  not changed for that long a packed R-tree is bulk-loaded from them (using Sort-Tile-Recursive) and
+  queries use it instead. Its nodes are full, tightly bound their children and are stored in a
+  single contiguous buffer, so queries visit far fewer nodes, especially for polygons of uneven
+  size. The packed tree is discarded as soon as any element changes.
  */
 
 /*!
@@ -102,12 +220,18 @@ GeometryQuadtree::GeometryQuadtree(const Envelope& extent,
  */
 GeometryQuadtree::~GeometryQuadtree()
 {
+  // the signalers are children of the elements, so they would otherwise outlive the tree
+  for (const Element& element : qAsConst(m_elementStorage))
+  {
+    disconnect(element.signaler, nullptr, this, nullptr);
+    delete element.signaler;
+  }
 }
 
 /*!
   \brief Adds the \a newGeoElement into the quadtree.
 
-  \note The tree will be re-built.
+  \note If the new element lies outside of the current tree, the tree will be expanded to cover it.
  */
 void GeometryQuadtree::appendGeoElment(GeoElement* newGeoElement)
 {
@@ -118,6 +242,92 @@ void GeometryQuadtree::appendGeoElment(GeoElement* newGeoElement)
   handleGeometryChange(newKey);
 }
 
+/*!
+  \brief Adds each of the \a newGeoElements into the quadtree.
+
+  The elements are inserted together, along with any other pending changes, and
+  \l treeChanged is emitted once.
+ */
+void GeometryQuadtree::appendGeoElements(const QList<GeoElement*>& newGeoElements)
+{
+  for (GeoElement* newGeoElement : newGeoElements)
+  {
+    if (!newGeoElement)
+      continue;
+
+    const int newKey = handleNewGeoElement(newGeoElement);
+    handleGeometryChange(newKey);
+  }
+}
+
+/*!
+  \brief Removes the \a geoElement from the quadtree.
+
+  Only the leaves which contain the element are updated and \l treeChanged is emitted once
+  the pending changes have been applied.
+ */
+void GeometryQuadtree::removeGeoElement(GeoElement* geoElement)
+{
+  auto findIt = m_elementKeys.constFind(geoElement);
+  if (findIt == m_elementKeys.constEnd())
+    return;
+
+  const int removedKey = findIt.value();
+  GeoElementSignaler* signaler = m_elementStorage.value(removedKey).signaler;
+  handleElementRemoved(removedKey);
+
+  // the element is no longer tracked, so its signaler is not needed
+  disconnect(signaler, nullptr, this, nullptr);
+  delete signaler;
+}
+
+/*!
+  \brief Returns how long, in milliseconds, the elements must be unchanged before queries use a
+  packed R-tree. A negative value (the default) means that the packed tree is never used.
+ */
+int GeometryQuadtree::staticIndexDelay() const
+{
+  return m_staticIndexDelay;
+}
+
+/*!
+  \brief Sets how long, in milliseconds, the elements must be unchanged before queries use a
+  packed R-tree to \a msecs.
+
+  This suits elements which rarely change, such as geofences. A negative value disables the packed tree.
+ */
+void GeometryQuadtree::setStaticIndexDelay(int msecs)
+{
+  m_staticIndexDelay = msecs;
+  if (m_staticIndexDelay < 0)
+  {
+    m_packedTree.reset();
+    if (m_staticIndexTimer)
+      m_staticIndexTimer->stop();
+
+    return;
+  }
+
+  if (!m_staticIndexTimer)
+  {
+    m_staticIndexTimer = new QTimer(this);
+    m_staticIndexTimer->setSingleShot(true);
+    connect(m_staticIndexTimer, &QTimer::timeout, this, &GeometryQuadtree::buildStaticIndex);
+  }
+
+  m_staticIndexTimer->setInterval(m_staticIndexDelay);
+  if (!m_packedTree)
+    m_staticIndexTimer->start();
+}
+
+/*!
+  \brief Returns whether queries are currently using the packed R-tree.
+ */
+bool GeometryQuadtree::isStaticIndexActive() const
+{
+  return m_packedTree != nullptr;
+}
+
 /*!
   \brief Returns the list of \l Geometry objects which are in quadtree cells which intersect \a geometry
 
@@ -132,137 +342,445 @@ QList<Geometry> GeometryQuadtree::candidateIntersections(const Geometry& geometr
 /*!
   \brief Returns the list of \l Geometry objects which are in quadtree cells which intersect \a extent
 
+  The geometry is returned in WGS84.
+
   \note No intersection test is carried out between the supplied Envelope and the results. For exact results,
   you should perform the desired geometry tests on the list of \l Geometry objects returned.
  */
 QList<Geometry> GeometryQuadtree::candidateIntersections(const Envelope& extent) const
 {
-  // ensure the extent is in WGS84
-  const Envelope wgs84 = GeometryEngine::project(extent, SpatialReference::wgs84());
+  Bounds wgs84Bounds;
+  if (!toWgs84Bounds(extent, wgs84Bounds))
+    return QList<Geometry>();
 
-  // obtain the indices of Geometry objects from quadtree nodes which intersect the extent
-  QSet<int> geomIds = m_tree->intersectingIds(wgs84);
+  return geometriesFor(wgs84Bounds);
+}
 
-  // collect the Geometry objects with an intersecting Id
-  QList<Geometry> results;
-  for(const int id: geomIds)
+/*!
+  \brief Returns the list of \l Geometry objects which are in quadtree cells which intersect \a location
+
+  The geometry is returned in WGS84.
+
+  \note No intersection test is carried out between the supplied point and the results. For exact results,
+  you should perform the desired geometry tests on the list of \l Geometry objects returned.
+ */
+QList<Geometry> GeometryQuadtree::candidateIntersections(const Point& location) const
+{
+  // ensure the location is in WGS84
+  const Point wgs84 = ProjectionUtils::toWgs84(location);
+  if (wgs84.isEmpty())
+    return QList<Geometry>();
+
+  Bounds wgs84Bounds;
+  wgs84Bounds.xMin = wgs84.x();
+  wgs84Bounds.xMax = wgs84.x();
+  wgs84Bounds.yMin = wgs84.y();
+  wgs84Bounds.yMax = wgs84.y();
+
+  return geometriesFor(wgs84Bounds);
+}
+
+/*!
+  \brief Returns up to \a count elements which are nearest to \a location and no further than \a maxDistance
+  meters from it.
+
+  The results are ordered by increasing distance. Polygons which contain the location have a distance of \c 0.
+
+  The tree is searched best-first, using the distance to each cell as a lower bound, so only the
+  cells which could hold a nearer element are visited.
+
+  If \a localFrameTolerance is not negative, and the error bound of a \l GeodesicUtils::LocalFrame
+  at the location covering \a maxDistance is within it, then distances are measured in that frame.
+  Polygons are then tested using their prepared edges rather than the GeometryEngine. Otherwise
+  distances are measured on the sphere.
+ */
+QList<GeometryQuadtree::Neighbour> GeometryQuadtree::nearestNeighbours(const Point& location, int count, double maxDistance, double localFrameTolerance) const
+{
+  QList<Neighbour> results;
+
+  // ensure the location is in WGS84
+  const Point wgs84 = ProjectionUtils::toWgs84(location);
+  if (wgs84.isEmpty() || count <= 0)
+    return results;
+
+  // short searches can be measured with planar arithmetic, if the error of doing so is small enough
+  const GeodesicUtils::LocalFrame frame(wgs84.x(), wgs84.y(), maxDistance);
+  const bool useFrame = frame.isWithinTolerance(localFrameTolerance);
+
+  // an element can be stored in more than one leaf: use a stamp to only measure (and report) it once
+  const unsigned int stamp = ++m_queryStamp;
+  auto entryDistance = [this, stamp, &wgs84, &frame, useFrame](int id) -> double
   {
-    // attempt to find the element Id in the lookup. If the element has been removed it may not be found
-    auto findIt = m_elementStorage.find(id);
-    if (findIt != m_elementStorage.end())
+    auto findIt = m_elementStorage.constFind(id);
+    if (findIt == m_elementStorage.constEnd())
+      return -1.0;
+
+    const Element& element = findIt.value();
+    if (element.queryStamp == stamp)
+      return -1.0;
+
+    element.queryStamp = stamp;
+
+    // use the packed coordinates where possible, avoiding the GeometryEngine
+    if (!element.packed.isEmpty())
+      return useFrame ? frame.distanceToPacked(element.packed) : GeodesicUtils::distanceToPacked(wgs84.x(), wgs84.y(), element.packed);
+
+    // the edges of a prepared polygon are measured in the same projection as the frame
+    if (useFrame && element.geometry.geometryType() == GeometryType::Polygon)
     {
-      GeoElementSignaler* element = findIt.value();
-      if (element)
-        results.push_back(element->geoElement()->geometry());
+      if (!element.prepared)
+        element.prepared = PreparedPolygon::create(element.geometry);
+
+      if (element.prepared)
+      {
+        if (element.prepared->contains(wgs84.x(), wgs84.y()))
+          return 0.0;
+
+        const double boundaryDistance = element.prepared->boundaryDistance(wgs84.x(), wgs84.y(), frame.radius());
+        if (boundaryDistance < frame.radius())
+          return boundaryDistance;
+      }
     }
+
+    return GeodesicUtils::distanceToGeometry(wgs84, element.geometry);
+  };
+
+  flushPendingChanges();
+
+  QVector<QuadTree::SearchResult> nearest;
+  if (m_packedTree)
+    m_packedTree->nearest(wgs84.x(), wgs84.y(), count, maxDistance, entryDistance, nearest);
+  else
+    m_tree->nearest(wgs84.x(), wgs84.y(), count, maxDistance, entryDistance, nearest);
+
+  results.reserve(nearest.size());
+  for (const QuadTree::SearchResult& result : nearest)
+  {
+    auto findIt = m_elementStorage.constFind(result.id);
+    if (findIt == m_elementStorage.constEnd())
+      continue;
+
+    const Element& element = findIt.value();
+    Neighbour neighbour;
+    neighbour.geoElement = element.geoElement;
+    neighbour.wgs84Geometry = element.geometry;
+    neighbour.distance = result.distance;
+    results.append(neighbour);
   }
 
   return results;
 }
 
 /*!
-  \brief Returns the list of \l Geometry objects which are in quadtree cells which intersect \a location
+  \brief Returns all of the elements within \a distance meters of \a location, ordered by increasing distance.
 
-  \note No intersection test is carried out between the supplied point and the results. For exact results,
-  you should perform the desired geometry tests on the list of \l Geometry objects returned.
+  Distances are measured in a local frame if its error is within \a localFrameTolerance.
+
+  \sa nearestNeighbours
  */
-QList<Geometry> GeometryQuadtree::candidateIntersections(const Point& location) const
+QList<GeometryQuadtree::Neighbour> GeometryQuadtree::withinDistance(const Point& location, double distance, double localFrameTolerance) const
+{
+  return nearestNeighbours(location, std::numeric_limits<int>::max(), distance, localFrameTolerance);
+}
+
+/*!
+  \brief Converts the \a wgs84Extent to \a bounds.
+
+  Returns \c false if the extent is empty or invalid.
+ */
+bool GeometryQuadtree::toBounds(const Envelope& wgs84Extent, Bounds& bounds)
 {
-  // ensure the extent is in WGS84
-  const Point wgs84 = GeometryEngine::project(location, SpatialReference::wgs84());
+  if (wgs84Extent.isEmpty())
+    return false;
 
-  // obtain the indices of Geometry objects from quadtree nodes which contain the location
-  QSet<int> geomIds = m_tree->intersectingIds(wgs84);
+  bounds.xMin = wgs84Extent.xMin();
+  bounds.yMin = wgs84Extent.yMin();
+  bounds.xMax = wgs84Extent.xMax();
+  bounds.yMax = wgs84Extent.yMax();
 
-  // collect the Geometry objects with an intersecting Id
+  // guard against invalid extents which could never be contained by the tree
+  return !(std::isnan(bounds.xMin) || std::isnan(bounds.xMax) ||
+           std::isnan(bounds.yMin) || std::isnan(bounds.yMax));
+}
+
+/*!
+  \brief Converts \a extent to WGS84 \a bounds, projecting it only if it is in another spatial reference.
+
+  Returns \c false if the extent is empty or invalid.
+ */
+bool GeometryQuadtree::toWgs84Bounds(const Envelope& extent, Bounds& bounds)
+{
+  return toBounds(ProjectionUtils::project(extent, SpatialReference::wgs84()), bounds);
+}
+
+/*!
+  \internal
+
+  Returns the geometry of each element with bounds which intersect \a wgs84Bounds.
+ */
+QList<Geometry> GeometryQuadtree::geometriesFor(const Bounds& wgs84Bounds) const
+{
+  // collect the cached Geometry objects with an intersecting Id
   QList<Geometry> results;
-  for(const int id: geomIds)
+  visitCandidates(wgs84Bounds, [&results](const Geometry& geometry, const Bounds&)
   {
-    // attempt to find the element Id in the lookup. If the element has been removed it may not be found
-    auto findIt = m_elementStorage.find(id);
-    if (findIt != m_elementStorage.end())
-    {
-      GeoElementSignaler* element = findIt.value();
-      if (element)
-        results.push_back(element->geoElement()->geometry());
-    }
-  }
+    results.push_back(geometry);
+    return true;
+  });
 
   return results;
 }
 
+/*!
+  \internal
+
+  Returns the ids of elements from the leaf nodes which intersect \a wgs84Bounds. The
+  buffer is re-used between queries so that it does not need to be re-allocated.
+ */
+const QVector<int>& GeometryQuadtree::candidateIds(const Bounds& wgs84Bounds) const
+{
+  flushPendingChanges();
+  if (m_packedTree)
+    m_packedTree->intersectingIds(wgs84Bounds, m_queryResults);
+  else
+    m_tree->intersectingIds(wgs84Bounds, m_queryResults);
+
+  return m_queryResults;
+}
+
 /*!
   \internal
  */
 void GeometryQuadtree::buildTree(const Envelope& extent)
 {
-  // ensure the tree's extent is in WGS84
-  const Envelope extentWgs84 = GeometryEngine::project(extent, SpatialReference::wgs84());
+  // ensure the tree's extent is in WGS84. If the supplied extent is empty
+  // the root will be reset when the first geometry is assigned
+  Bounds rootBounds;
+  if (toBounds(ProjectionUtils::project(extent, SpatialReference::wgs84()), rootBounds))
+    rootBounds = QuadTree::padded(rootBounds);
+  else
+    rootBounds = Bounds{std::nan(""), std::nan(""), std::nan(""), std::nan("")};
 
-  // build the (currently empty) tree to the desired depth
-  m_tree.reset(new QuadTree(0, extentWgs84.xMin(), extentWgs84.xMax(), extentWgs84.yMin(), extentWgs84.yMax()));
+  // build the (currently empty) tree
+  m_tree.reset(new QuadTree(rootBounds, m_maxLevels));
+  m_dirtyIds.clear();
+  m_changedBounds.clear();
+  handleTreeModified();
 
   // assign the geometry of each element to the tree, along with its id in the lookup
-  auto it = m_elementStorage.cbegin();
-  auto itEnd = m_elementStorage.cend();
-  for (; it != itEnd; ++it)
+  for (auto it = m_elementStorage.begin(); it != m_elementStorage.end(); ++it)
   {
-    GeoElementSignaler* element = it.value();
-    if (!element)
+    Element& element = it.value();
+    element.indexed = false;
+    element.dirty = false;
+    if (!element.signaler)
       continue;
 
-    const Geometry wgs84 = GeometryEngine::project(element->geoElement()->geometry(), SpatialReference::wgs84());
-    m_tree->assign(wgs84.extent(), it.key(), m_maxLevels);
-  }
+    // cache the WGS84 geometry so that it does not need to be projected for each query
+    element.geometry = ProjectionUtils::toWgs84(element.signaler->geoElement()->geometry());
+    GeodesicUtils::pack(element.geometry, element.packed);
+    element.prepared.reset();
+    if (!toBounds(element.geometry.extent(), element.bounds))
+      continue;
 
-  // remove any nodes from the tree which contain no geometry
-  m_tree->prune();
+    // grow the tree if the supplied extent does not cover this geometry
+    if (!m_tree->contains(element.bounds))
+      m_tree->grow(element.bounds);
+
+    m_tree->insert(it.key(), element.bounds);
+    element.indexed = true;
+  }
 
   emit treeChanged();
 }
 
 /*!
   \internal
+
+  Marks the element with \a changedId as dirty. All dirty elements are re-indexed together, once per
+  event-loop turn, or before the next query (whichever comes first).
  */
 void GeometryQuadtree::handleGeometryChange(int changedId)
 {
-  const GeoElementSignaler* changedElement = m_elementStorage.value(changedId);
-  if (!changedElement)
+  auto findIt = m_elementStorage.find(changedId);
+  if (findIt == m_elementStorage.end())
     return;
 
-  const Geometry wgs84Geom = GeometryEngine::project(changedElement->geoElement()->geometry(), SpatialReference::wgs84());
-  const Envelope wgs84Extent = wgs84Geom.extent();
+  Element& changedElement = findIt.value();
+  if (!changedElement.dirty)
+  {
+    changedElement.dirty = true;
+    m_dirtyIds.append(changedId);
+  }
+
+  handleTreeModified();
+  scheduleFlush();
+}
+
+/*!
+  \internal
 
-  // if the extent of the changed geom is the same or smaller than the existing tree, it can still be used
-  if (m_tree->m_xMin <= wgs84Extent.xMin() &&
-      m_tree->m_xMax >= wgs84Extent.xMax() &&
-      m_tree->m_yMin <= wgs84Extent.yMin() &&
-      m_tree->m_yMax >= wgs84Extent.yMax())
+  Removes the element with \a removedId from the storage and the tree.
+ */
+void GeometryQuadtree::handleElementRemoved(int removedId)
+{
+  auto findIt = m_elementStorage.find(removedId);
+  if (findIt == m_elementStorage.end())
+    return;
+
+  const Element& element = findIt.value();
+  if (element.indexed)
   {
-    m_tree->removeId(changedId);
-    m_tree->assign(wgs84Geom.extent(), changedId, m_maxLevels);
-    m_tree->prune();
+    m_tree->remove(removedId, element.bounds);
+    m_changedBounds.append(element.bounds);
+  }
+
+  // any pending change for this element is ignored once it is no longer in storage
+  m_elementKeys.remove(element.geoElement);
+  m_elementStorage.erase(findIt);
+
+  m_changePending = true;
+  handleTreeModified();
+  scheduleFlush();
+}
+
+/*!
+  \internal
+
+  Requests a call to \l flushChanges on the next event-loop turn, unless one is already pending.
+ */
+void GeometryQuadtree::scheduleFlush()
+{
+  if (m_flushScheduled)
+    return;
+
+  m_flushScheduled = true;
+  QTimer::singleShot(0, this, [this]()
+  {
+    m_flushScheduled = false;
+    flushChanges();
+
+    if (!m_changePending)
+      return;
+
+    m_changePending = false;
+    const QVector<Bounds> changedBounds = m_changedBounds;
+    m_changedBounds.clear();
+    emit elementsChanged(changedBounds);
     emit treeChanged();
+  });
+}
+
+/*!
+  \internal
+
+  Re-indexes every dirty element in a single pass.
+
+  \l treeChanged is emitted by the scheduled flush, so that queries which
+  apply pending changes do not emit signals.
+ */
+void GeometryQuadtree::flushChanges()
+{
+  if (m_dirtyIds.isEmpty())
+    return;
+
+  for (const int dirtyId : m_dirtyIds)
+  {
+    auto findIt = m_elementStorage.find(dirtyId);
+    if (findIt == m_elementStorage.end())
+      continue;
+
+    Element& element = findIt.value();
+    element.dirty = false;
+    reindexElement(dirtyId, element);
   }
-  // otherwise calculate the new extent and rebuild the tree
-  else
+
+  m_dirtyIds.clear();
+  m_changePending = true;
+}
+
+/*!
+  \internal
+
+  Applies any pending changes before the tree is queried.
+ */
+void GeometryQuadtree::flushPendingChanges() const
+{
+  if (!m_dirtyIds.isEmpty())
+    const_cast<GeometryQuadtree*>(this)->flushChanges();
+}
+
+/*!
+  \internal
+
+  Discards the packed R-tree, since it no longer matches the elements, and restarts the wait
+  before it is built again.
+ */
+void GeometryQuadtree::handleTreeModified()
+{
+  m_packedTree.reset();
+  if (m_staticIndexTimer && m_staticIndexDelay >= 0)
+    m_staticIndexTimer->start();
+}
+
+/*!
+  \internal
+
+  Bulk-loads the packed R-tree from the bounds of every indexed element.
+ */
+void GeometryQuadtree::buildStaticIndex()
+{
+  flushPendingChanges();
+
+  QVector<QuadTree::LeafEntry> entries;
+  entries.reserve(m_elementStorage.size());
+  for (auto it = m_elementStorage.cbegin(); it != m_elementStorage.cend(); ++it)
   {
-    QList<Geometry> allGeom;
-    for(auto it = m_elementStorage.begin(); it != m_elementStorage.end(); ++it)
-    {
-      GeoElementSignaler* element = it.value();
-      if (!element)
-        continue;
+    if (!it.value().indexed)
+      continue;
 
-      if (element->geoElement()->geometry().isEmpty())
-        continue;
+    QuadTree::LeafEntry entry;
+    entry.id = it.key();
+    entry.bounds = it.value().bounds;
+    entries.append(entry);
+  }
 
-      allGeom.append(GeometryEngine::project(element->geoElement()->geometry(), SpatialReference::wgs84()));
-    }
+  m_packedTree.reset(new PackedRTree(entries));
+}
+
+/*!
+  \internal
 
-    const Geometry newExtent = GeometryEngine::combineExtents(allGeom);
-    buildTree(newExtent);
+  Updates the cached WGS84 geometry of \a element (with \a id) and moves it to the correct leaves of the tree.
+ */
+void GeometryQuadtree::reindexElement(int id, Element& element)
+{
+  if (!element.signaler)
+    return;
+
+  // remove the element from the leaves it was previously assigned to
+  if (element.indexed)
+  {
+    m_tree->remove(id, element.bounds);
+    m_changedBounds.append(element.bounds);
+    element.indexed = false;
   }
+
+  // update the cached WGS84 geometry
+  element.geometry = ProjectionUtils::toWgs84(element.signaler->geoElement()->geometry());
+  GeodesicUtils::pack(element.geometry, element.packed);
+  element.prepared.reset();
+  if (!toBounds(element.geometry.extent(), element.bounds))
+    return;
+
+  // if the changed geom lies outside of the existing tree, grow the tree upwards to cover it.
+  // This only touches the root so the cost does not depend on the number of elements
+  if (!m_tree->contains(element.bounds))
+    m_tree->grow(element.bounds);
+
+  m_tree->insert(id, element.bounds);
+  m_changedBounds.append(element.bounds);
+  element.indexed = true;
 }
 
 /*!
@@ -277,49 +795,30 @@ int GeometryQuadtree::handleNewGeoElement(GeoElement* geoElement)
   if (!geoElement)
     return -1;
 
+  // if the element is already in the tree, just return its key
+  auto findIt = m_elementKeys.constFind(geoElement);
+  if (findIt != m_elementKeys.constEnd())
+    return findIt.value();
+
   GeoElementSignaler* signaler = new GeoElementSignaler(geoElement, GeoElementUtils::toQObject(geoElement));
 
-  m_elementStorage.insert(m_nextKey, signaler);
+  Element newElement;
+  newElement.signaler = signaler;
+  newElement.geoElement = geoElement;
+  m_elementStorage.insert(m_nextKey, newElement);
+  m_elementKeys.insert(geoElement, m_nextKey);
   const int insertedKey = m_nextKey;
   m_nextKey++;
 
-  connect(signaler, &GeoElementSignaler::geometryChanged, this, [this, signaler]()
+  // the connections capture the key so that no search of the storage is required
+  connect(signaler, &GeoElementSignaler::geometryChanged, this, [this, insertedKey]()
   {
-    auto it = m_elementStorage.cbegin();
-    auto itEnd = m_elementStorage.cend();
-    for (; it != itEnd; ++it)
-    {
-      GeoElementSignaler* testElement = it.value();
-      if (!testElement)
-        continue;
-
-      if (testElement == signaler)
-      {
-        handleGeometryChange(it.key());
-        return;
-      }
-    }
+    handleGeometryChange(insertedKey);
   });
 
-  connect(signaler, &GeoElementSignaler::destroyed, this, [this, signaler]()
+  connect(signaler, &GeoElementSignaler::destroyed, this, [this, insertedKey]()
   {
-    auto it = m_elementStorage.cbegin();
-    auto itEnd = m_elementStorage.cend();
-    for (; it != itEnd; ++it)
-    {
-      GeoElementSignaler* testElement = it.value();
-      if (!testElement)
-        continue;
-
-      if (testElement == signaler)
-      {
-        m_tree->removeId(it.key());
-        m_tree->prune();
-        m_elementStorage.remove(it.key());
-        emit treeChanged();
-        return;
-      }
-    }
+    handleElementRemoved(insertedKey);
   });
 
   return insertedKey;
@@ -328,330 +827,695 @@ int GeometryQuadtree::handleNewGeoElement(GeoElement* geoElement)
 /*!
   \internal
  */
-GeometryQuadtree::QuadTree::QuadTree(int level, double xMin, double xMax, double yMin, double yMax):
-  m_level(level),
-  m_xMin(xMin),
-  m_xMax(xMax),
-  m_yMin(yMin),
-  m_yMax(yMax)
+GeometryQuadtree::QuadTree::QuadTree(const Bounds& rootBounds, int maxLevels):
+  m_maxLevels(maxLevels)
 {
+  m_root = allocateNode(rootBounds, 0);
 }
 
 /*!
   \internal
+
+  Returns whether the root node covers a valid (non-empty) area.
  */
-GeometryQuadtree::QuadTree::~QuadTree()
+bool GeometryQuadtree::QuadTree::isValid() const
 {
-  if (m_tl)
-    delete m_tl;
+  if (m_root < 0)
+    return false;
 
-  if (m_tr)
-    delete m_tr;
+  // NaN bounds (e.g. from an empty extent) fail all of these tests
+  const Bounds& root = m_nodes[m_root].bounds;
+  return (root.xMax > root.xMin &&
+          root.yMax > root.yMin);
+}
 
-  if (m_bl)
-    delete m_bl;
+/*!
+  \internal
 
-  if (m_br)
-    delete m_br;
+  Returns whether the root node fully contains \a bounds.
+ */
+bool GeometryQuadtree::QuadTree::contains(const Bounds& bounds) const
+{
+  const Bounds& root = m_nodes[m_root].bounds;
+  return (bounds.xMin >= root.xMin &&
+          bounds.xMax <= root.xMax &&
+          bounds.yMin >= root.yMin &&
+          bounds.yMax <= root.yMax);
 }
 
-GeometryQuadtree::QuadTree* GeometryQuadtree::QuadTree::createTopLeft(int maxLevels)
-{
-  // if we have not reached the max depth of the tree, add the child nodes
-  if (m_level > maxLevels)
-    return nullptr;
+/*!
+  \internal
 
-  const double xMid = ((m_xMax - m_xMin) * 0.5) + m_xMin;
-  const double yMid = ((m_yMax - m_yMin) * 0.5) + m_yMin;
+  Adds \a id, with the WGS84 \a bounds, to every leaf which it overlaps.
+ */
+void GeometryQuadtree::QuadTree::insert(int id, const Bounds& bounds)
+{
+  if (!intersects(m_nodes[m_root].bounds, bounds))
+    return;
 
-  return new QuadTree(m_level +1, m_xMin, xMid, yMid, m_yMax);
+  LeafEntry entry;
+  entry.id = id;
+  entry.bounds = bounds;
+  insertInto(m_root, entry);
 }
 
-GeometryQuadtree::QuadTree* GeometryQuadtree::QuadTree::createTopRight(int maxLevels)
+/*!
+  \internal
+
+  Removes \a id from every leaf overlapping \a bounds (the bounds it was inserted with).
+  Any nodes which are left empty are returned to the pool.
+ */
+void GeometryQuadtree::QuadTree::remove(int id, const Bounds& bounds)
 {
-  // if we have not reached the max depth of the tree, add the child nodes
-  if (m_level > maxLevels)
-    return nullptr;
+  removeFrom(m_root, id, bounds);
+}
 
-  const double xMid = ((m_xMax - m_xMin) * 0.5) + m_xMin;
-  const double yMid = ((m_yMax - m_yMin) * 0.5) + m_yMin;
+/*!
+  \internal
 
-  return new QuadTree(m_level + 1, xMid, m_xMax, yMid, m_yMax);
-}
+  Expands the tree until the root node covers \a bounds.
 
-GeometryQuadtree::QuadTree* GeometryQuadtree::QuadTree::createBottomLeft(int maxLevels)
+  Each step adds a new root node, twice the size of the current root, which has the old root
+  as one of its children. The quadrant used for the old root is chosen so that the tree grows towards
+  \a bounds. Existing nodes are left untouched so the cell size of the leaf nodes does not change.
+ */
+void GeometryQuadtree::QuadTree::grow(const Bounds& bounds)
 {
-  // if we have not reached the max depth of the tree, add the child nodes
-  if (m_level > maxLevels)
-    return nullptr;
+  Node& root = m_nodes[m_root];
 
-  const double xMid = ((m_xMax - m_xMin) * 0.5) + m_xMin;
-  const double yMid = ((m_yMax - m_yMin) * 0.5) + m_yMin;
+  // if the tree does not contain any geometry (or has never been given a valid extent) it can simply be reset
+  if (!isValid() || (root.leaf && root.entries.isEmpty()))
+  {
+    root = Node();
+    root.bounds = padded(bounds);
+    return;
+  }
 
-  return new QuadTree(m_level + 1, m_xMin, xMid, m_yMin, yMid);
+  while (!contains(bounds))
+  {
+    const Bounds oldBounds = m_nodes[m_root].bounds;
+    const double width = oldBounds.xMax - oldBounds.xMin;
+    const double height = oldBounds.yMax - oldBounds.yMin;
+    const bool growWest = bounds.xMin < oldBounds.xMin;
+    const bool growSouth = bounds.yMin < oldBounds.yMin;
+
+    Bounds newBounds;
+    newBounds.xMin = growWest ? oldBounds.xMin - width : oldBounds.xMin;
+    newBounds.yMin = growSouth ? oldBounds.yMin - height : oldBounds.yMin;
+    newBounds.xMax = newBounds.xMin + (2.0 * width);
+    newBounds.yMax = newBounds.yMin + (2.0 * height);
+
+    // the new root is one level above the current root
+    const int oldRoot = m_root;
+    const int newRoot = allocateNode(newBounds, m_nodes[oldRoot].level - 1);
+    const int quadrant = growWest ? (growSouth ? TopRight : BottomRight)
+                                  : (growSouth ? TopLeft : BottomLeft);
+
+    Node& newRootNode = m_nodes[newRoot];
+    newRootNode.leaf = false;
+    newRootNode.children[quadrant] = oldRoot;
+    m_root = newRoot;
+  }
 }
 
-GeometryQuadtree::QuadTree* GeometryQuadtree::QuadTree::createBottomRight(int maxLevels)
-{
-  // if we have not reached the max depth of the tree, add the child nodes
-  if (m_level > maxLevels)
-    return nullptr;
+/*!
+  \internal
 
-  const double xMid = ((m_xMax - m_xMin) * 0.5) + m_xMin;
-  const double yMid = ((m_yMax - m_yMin) * 0.5) + m_yMin;
+  Fills \a results with the ids of all elements with bounds intersecting \a bounds.
+  The \a results are cleared first and each id is only reported once.
+ */
+void GeometryQuadtree::QuadTree::intersectingIds(const Bounds& bounds, QVector<int>& results) const
+{
+  results.clear();
+  collectIds(m_root, bounds, results);
 
-  return new QuadTree(m_level + 1, xMid, m_xMax, m_yMin, yMid);
+  // an element which spans more than one leaf will have been reported more than once
+  std::sort(results.begin(), results.end());
+  results.erase(std::unique(results.begin(), results.end()), results.end());
 }
 
 /*!
   \internal
+
+  Fills \a results with up to \a count entries nearest to (\a lon, \a lat), ordered by distance.
+
+  Cells and entries are queued by the distance to their bounds, which is a lower bound for the distance
+  to any geometry they contain. An entry's exact distance is only calculated (using \a entryDistance,
+  which returns a negative value for entries to skip) when it reaches the front of the queue and
+  it is reported once its exact distance reaches the front of the queue.
  */
-bool GeometryQuadtree::QuadTree::assign(const Envelope& extent, int geomIndex, int maxLevels)
+template <typename EntryDistance>
+void GeometryQuadtree::QuadTree::nearest(double lon, double lat, int count, double maxDistance,
+                                         EntryDistance&& entryDistance, QVector<SearchResult>& results) const
 {
-  // if the extent of the incoming geometry does not lie within this node, return
-  if (!intersects(extent))
-    return false;
+  results.clear();
+  if (!isValid())
+    return;
 
-  // record this geometry index
-  m_geometryIds.insert(geomIndex);
+  // the queue is re-used between searches and is kept as a min-heap on the distance
+  m_searchQueue.clear();
+  auto compare = [](const SearchItem& a, const SearchItem& b)
+  {
+    return a.distance > b.distance;
+  };
 
-  // (recursively) attempt to assign the geomeytry to each child node
-  // if the node already exists, just assign
-  if (m_tl)
+  auto push = [this, maxDistance, &compare](double distance, int index, SearchItemType type)
   {
-    m_tl->assign(extent, geomIndex, maxLevels);
-  }
-  // otherwise, create a temporary node and only keep it if it will contain this geometry
-  else
+    if (distance > maxDistance)
+      return;
+
+    SearchItem item;
+    item.distance = distance;
+    item.index = index;
+    item.type = type;
+    m_searchQueue.push_back(item);
+    std::push_heap(m_searchQueue.begin(), m_searchQueue.end(), compare);
+  };
+
+  auto boundsDistance = [lon, lat](const Bounds& bounds)
   {
-    QuadTree* temp = createTopLeft(maxLevels);
-    if (temp && temp->assign(extent, geomIndex, maxLevels))
-      m_tl = temp;
-    else
-      delete temp;
-  }
+    return GeodesicUtils::distanceToBounds(lon, lat, bounds.xMin, bounds.yMin, bounds.xMax, bounds.yMax);
+  };
 
-  if (m_tr)
-  {
-    m_tr->assign(extent, geomIndex, maxLevels);
-  }
-  else
+  push(boundsDistance(m_nodes[m_root].bounds), m_root, SearchItemType::Node);
+
+  while (!m_searchQueue.empty())
   {
-    QuadTree* temp = createTopRight(maxLevels);
-    if (temp && temp->assign(extent, geomIndex, maxLevels))
-      m_tr = temp;
-    else
-      delete temp;
+    std::pop_heap(m_searchQueue.begin(), m_searchQueue.end(), compare);
+    const SearchItem item = m_searchQueue.back();
+    m_searchQueue.pop_back();
+
+    switch (item.type)
+    {
+    case SearchItemType::Result:
+    {
+      // nothing left in the queue can be closer than this
+      SearchResult result;
+      result.id = item.index;
+      result.distance = item.distance;
+      results.append(result);
+      if (results.size() >= count)
+        return;
+
+      break;
+    }
+    case SearchItemType::Entry:
+    {
+      const double distance = entryDistance(item.index);
+      if (distance >= 0.0)
+        push(distance, item.index, SearchItemType::Result);
+
+      break;
+    }
+    case SearchItemType::Node:
+    {
+      const Node& node = m_nodes[item.index];
+      if (node.leaf)
+      {
+        for (const LeafEntry& entry : node.entries)
+          push(boundsDistance(entry.bounds), entry.id, SearchItemType::Entry);
+      }
+      else
+      {
+        for (int quadrant = 0; quadrant < 4; ++quadrant)
+        {
+          const int child = node.children[quadrant];
+          if (child >= 0)
+            push(boundsDistance(m_nodes[child].bounds), child, SearchItemType::Node);
+        }
+      }
+
+      break;
+    }
+    }
   }
+}
+
+/*!
+  \internal
+
+  Returns whether \a a and \a b overlap (including touching at an edge).
+ */
+bool GeometryQuadtree::QuadTree::intersects(const Bounds& a, const Bounds& b)
+{
+  return (a.xMin <= b.xMax &&
+          a.xMax >= b.xMin &&
+          a.yMin <= b.yMax &&
+          a.yMax >= b.yMin);
+}
+
+/*!
+  \internal
 
-  if (m_bl)
+  Returns \a bounds, expanded if required so that it is never smaller than the minimum
+  cell size for the root of the tree.
+ */
+GeometryQuadtree::Bounds GeometryQuadtree::QuadTree::padded(const Bounds& bounds)
+{
+  Bounds result = bounds;
+  if ((result.xMax - result.xMin) < MinimumRootSize)
   {
-    m_bl->assign(extent, geomIndex, maxLevels);
+    const double xMid = (result.xMin + result.xMax) * 0.5;
+    result.xMin = xMid - (MinimumRootSize * 0.5);
+    result.xMax = xMid + (MinimumRootSize * 0.5);
   }
-  else
+
+  if ((result.yMax - result.yMin) < MinimumRootSize)
   {
-    QuadTree* temp = createBottomLeft(maxLevels);
-    if (temp && temp->assign(extent, geomIndex, maxLevels))
-      m_bl = temp;
-    else
-      delete temp;
+    const double yMid = (result.yMin + result.yMax) * 0.5;
+    result.yMin = yMid - (MinimumRootSize * 0.5);
+    result.yMax = yMid + (MinimumRootSize * 0.5);
   }
 
-  if (m_br)
+  return result;
+}
+
+/*!
+  \internal
+
+  Returns the index of a new leaf node, re-using a released node if one is available.
+ */
+int GeometryQuadtree::QuadTree::allocateNode(const Bounds& bounds, int level)
+{
+  int nodeIndex = -1;
+  if (!m_freeNodes.empty())
   {
-    m_br->assign(extent, geomIndex, maxLevels);
+    nodeIndex = m_freeNodes.back();
+    m_freeNodes.pop_back();
+    m_nodes[nodeIndex] = Node();
   }
   else
   {
-    QuadTree* temp = createBottomRight(maxLevels);
-    if (temp && temp->assign(extent, geomIndex, maxLevels))
-      m_br = temp;
-    else
-      delete temp;
+    nodeIndex = static_cast<int>(m_nodes.size());
+    m_nodes.emplace_back();
   }
 
-  return true;
+  Node& node = m_nodes[nodeIndex];
+  node.bounds = bounds;
+  node.level = level;
+  return nodeIndex;
 }
 
 /*!
   \internal
+
+  Returns the node at \a nodeIndex (which must be an empty leaf) to the pool.
  */
-void GeometryQuadtree::QuadTree::prune()
+void GeometryQuadtree::QuadTree::releaseNode(int nodeIndex)
 {
-  // for each existing child node remove the node (and any children if they are empty)
-  if (m_tl)
+  m_nodes[nodeIndex].entries.clear();
+  m_freeNodes.push_back(nodeIndex);
+}
+
+/*!
+  \internal
+ */
+GeometryQuadtree::Bounds GeometryQuadtree::QuadTree::quadrantBounds(int nodeIndex, int quadrant) const
+{
+  const Bounds& bounds = m_nodes[nodeIndex].bounds;
+  const double xMid = ((bounds.xMax - bounds.xMin) * 0.5) + bounds.xMin;
+  const double yMid = ((bounds.yMax - bounds.yMin) * 0.5) + bounds.yMin;
+
+  switch (quadrant)
   {
-    // remove the node (and all of it's children) if it is empty
-    if (m_tl->m_geometryIds.empty())
-    {
-      delete m_tl;
-      m_tl = nullptr;
-    }
-    // (recursively) call prune on the child
-    else
-    {
-      m_tl->prune();
-    }
+  case TopLeft:
+    return Bounds{bounds.xMin, yMid, xMid, bounds.yMax};
+  case TopRight:
+    return Bounds{xMid, yMid, bounds.xMax, bounds.yMax};
+  case BottomLeft:
+    return Bounds{bounds.xMin, bounds.yMin, xMid, yMid};
+  default:
+    return Bounds{xMid, bounds.yMin, bounds.xMax, yMid};
+  }
+}
+
+/*!
+  \internal
+ */
+void GeometryQuadtree::QuadTree::insertInto(int nodeIndex, const LeafEntry& entry)
+{
+  if (m_nodes[nodeIndex].leaf)
+  {
+    m_nodes[nodeIndex].entries.append(entry);
+    if (m_nodes[nodeIndex].entries.size() > LeafCapacity && m_nodes[nodeIndex].level < m_maxLevels)
+      split(nodeIndex);
+
+    return;
   }
 
-  if (m_tr)
+  // (recursively) assign the entry to each child quadrant it overlaps, creating the child if required.
+  // Note that the node pool may be re-allocated by allocateNode so nodes are always accessed by index
+  for (int quadrant = 0; quadrant < 4; ++quadrant)
   {
-    if (m_tr->m_geometryIds.empty())
-    {
-      delete m_tr;
-      m_tr = nullptr;
-    }
-    else
+    const Bounds childBounds = quadrantBounds(nodeIndex, quadrant);
+    if (!intersects(childBounds, entry.bounds))
+      continue;
+
+    int child = m_nodes[nodeIndex].children[quadrant];
+    if (child < 0)
     {
-      m_tr->prune();
+      child = allocateNode(childBounds, m_nodes[nodeIndex].level + 1);
+      m_nodes[nodeIndex].children[quadrant] = child;
     }
+
+    insertInto(child, entry);
   }
+}
+
+/*!
+  \internal
 
-  if (m_bl)
+  Returns \c true if the node at \a nodeIndex is empty after the removal.
+ */
+bool GeometryQuadtree::QuadTree::removeFrom(int nodeIndex, int id, const Bounds& bounds)
+{
+  Node& node = m_nodes[nodeIndex];
+  if (node.leaf)
   {
-    if (m_bl->m_geometryIds.empty())
-    {
-      delete m_bl;
-      m_bl = nullptr;
-    }
-    else
+    for (int i = 0; i < node.entries.size(); ++i)
     {
-      m_bl->prune();
+      if (node.entries[i].id != id)
+        continue;
+
+      // the order of entries in a leaf is not significant
+      node.entries[i] = node.entries.last();
+      node.entries.removeLast();
+      break;
     }
+
+    return node.entries.isEmpty();
   }
 
-  if (m_br)
+  bool hasChildren = false;
+  for (int quadrant = 0; quadrant < 4; ++quadrant)
   {
-    if (m_br->m_geometryIds.empty())
-    {
-      delete m_br;
-      m_br = nullptr;
-    }
-    else
+    const int child = node.children[quadrant];
+    if (child < 0)
+      continue;
+
+    if (intersects(m_nodes[child].bounds, bounds) && removeFrom(child, id, bounds))
     {
-      m_br->prune();
+      // remove the child if it is now empty
+      releaseNode(child);
+      node.children[quadrant] = -1;
+      continue;
     }
+
+    hasChildren = true;
   }
+
+  // an internal node with no remaining children reverts to being an (empty) leaf
+  if (!hasChildren)
+    node.leaf = true;
+
+  return !hasChildren && nodeIndex != m_root;
 }
 
 /*!
   \internal
+
+  Converts the leaf at \a nodeIndex into an internal node and re-distributes its entries.
  */
-QSet<int> GeometryQuadtree::QuadTree::intersectingIds(const Envelope& extent) const
+void GeometryQuadtree::QuadTree::split(int nodeIndex)
 {
-  // if this node contains no geometry indices there is no intersection
-  if (m_geometryIds.empty())
-    return QSet<int>();
-
-  // if this node does not intersect with the supplied extent, there is no intersection
-  if (!intersects(extent))
-    return QSet<int>();
-
-  // if this node intersects but has no children, it must be a leaf node: return all geometry indices
-  if (!m_tl && !m_tr && !m_bl && !m_br)
-    return m_geometryIds;
-
-  // for each existing child node, (recursively) build up the set of intersecting indices
-  QSet<int> result;
-  if (m_tl)
-    result += m_tl->intersectingIds(extent);
+  // only split if it separates the entries: each child must hold fewer entries than this node and large
+  // entries (which would be copied into several children) must not more than double the number of entries
+  const QVarLengthArray<LeafEntry, LeafCapacity> entries = m_nodes[nodeIndex].entries;
+  int totalChildEntries = 0;
+  for (int quadrant = 0; quadrant < 4; ++quadrant)
+  {
+    const Bounds childBounds = quadrantBounds(nodeIndex, quadrant);
+    int childEntries = 0;
+    for (const LeafEntry& entry : entries)
+    {
+      if (intersects(childBounds, entry.bounds))
+        ++childEntries;
+    }
 
-  if (m_tr)
-    result += m_tr->intersectingIds(extent);
+    if (childEntries == entries.size())
+      return;
 
-  if (m_bl)
-    result += m_bl->intersectingIds(extent);
+    totalChildEntries += childEntries;
+  }
 
-  if (m_br)
-    result += m_br->intersectingIds(extent);
+  if (totalChildEntries > (2 * entries.size()))
+    return;
 
-  return result;
+  m_nodes[nodeIndex].entries.clear();
+  m_nodes[nodeIndex].leaf = false;
+  for (const LeafEntry& entry : entries)
+    insertInto(nodeIndex, entry);
 }
 
 /*!
   \internal
  */
-QSet<int> GeometryQuadtree::QuadTree::intersectingIds(const Point& location) const
+void GeometryQuadtree::QuadTree::collectIds(int nodeIndex, const Bounds& bounds, QVector<int>& results) const
 {
-  // if this node contains no geometry indices, there is no intersection
-  if (m_geometryIds.empty())
-    return QSet<int>();
+  const Node& node = m_nodes[nodeIndex];
+  if (!intersects(node.bounds, bounds))
+    return;
 
-  // if this node does not intersect with the supplied extent, there is no intersection
-  if (!intersects(location))
-    return QSet<int>();
+  if (node.leaf)
+  {
+    for (const LeafEntry& entry : node.entries)
+    {
+      if (intersects(entry.bounds, bounds))
+        results.append(entry.id);
+    }
 
-  // if this node intesects but has no children, it must be a leaf node: return all geometry indices
-  if (!m_tl && !m_tr && !m_bl && !m_br)
-    return m_geometryIds;
+    return;
+  }
 
-  // for each existing child node, (recursively) build up the set of intersecting indices
-  QSet<int> result;
-  if (m_tl)
-    result += m_tl->intersectingIds(location);
+  for (int quadrant = 0; quadrant < 4; ++quadrant)
+  {
+    const int child = node.children[quadrant];
+    if (child >= 0)
+      collectIds(child, bounds, results);
+  }
+}
 
-  if (m_tr)
-    result += m_tr->intersectingIds(location);
+/*!
+  \internal
 
-  if (m_bl)
-    result += m_bl->intersectingIds(location);
+  Bulk-loads the tree with \a entries.
 
-  if (m_br)
-    result += m_br->intersectingIds(location);
+  Each level is ordered using Sort-Tile-Recursive: the items are sorted by the x coordinate of
+  their centers and cut into vertical slices, each slice is sorted by the y coordinate and cut
+  into runs of \c NodeCapacity items, and each run becomes a node of the next level. This gives
+  full nodes with tight, mostly disjoint, bounds. Every entry and node is stored in a single
+  contiguous buffer.
+ */
+GeometryQuadtree::PackedRTree::PackedRTree(const QVector<QuadTree::LeafEntry>& entries)
+{
+  m_entryCount = entries.size();
+  if (m_entryCount == 0)
+    return;
 
-  return result;
+  // every level is at most a sixteenth of the size of the one below it
+  m_nodes.reserve(m_entryCount + m_entryCount / (NodeCapacity - 1) + 1);
+  for (const QuadTree::LeafEntry& entry : entries)
+  {
+    PackedNode node;
+    node.bounds = entry.bounds;
+    node.first = entry.id;
+    m_nodes.push_back(node);
+  }
+
+  int levelBegin = 0;
+  int levelEnd = m_entryCount;
+  while (levelEnd - levelBegin > 1)
+  {
+    sortTileRecursive(levelBegin, levelEnd);
+
+    // the runs were cut by sortTileRecursive, which leaves the last node of each slice partly filled
+    const int levelCount = levelEnd - levelBegin;
+    const int nodeCount = (levelCount + NodeCapacity - 1) / NodeCapacity;
+    const int sliceCount = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(nodeCount))));
+    const int sliceSize = sliceCount * NodeCapacity;
+    for (int sliceBegin = levelBegin; sliceBegin < levelEnd; sliceBegin += sliceSize)
+    {
+      const int sliceEnd = std::min(levelEnd, sliceBegin + sliceSize);
+      for (int first = sliceBegin; first < sliceEnd; first += NodeCapacity)
+      {
+        PackedNode parent;
+        parent.first = first;
+        parent.count = std::min(NodeCapacity, sliceEnd - first);
+        parent.bounds = m_nodes[first].bounds;
+        for (int child = first + 1; child < first + parent.count; ++child)
+        {
+          const Bounds& childBounds = m_nodes[child].bounds;
+          parent.bounds.xMin = std::min(parent.bounds.xMin, childBounds.xMin);
+          parent.bounds.yMin = std::min(parent.bounds.yMin, childBounds.yMin);
+          parent.bounds.xMax = std::max(parent.bounds.xMax, childBounds.xMax);
+          parent.bounds.yMax = std::max(parent.bounds.yMax, childBounds.yMax);
+        }
+
+        m_nodes.push_back(parent);
+      }
+    }
+
+    levelBegin = levelEnd;
+    levelEnd = static_cast<int>(m_nodes.size());
+  }
+
+  m_root = levelBegin;
 }
 
 /*!
   \internal
+
+  Orders the items from \a begin to \a end into vertical slices, each sorted by latitude.
  */
-bool GeometryQuadtree::QuadTree::contains(const Envelope& extent) const
+void GeometryQuadtree::PackedRTree::sortTileRecursive(int begin, int end)
 {
-  return (extent.xMin() >= m_xMin &&
-          extent.xMax() <= m_xMax &&
-          extent.yMin() >= m_yMin &&
-          extent.yMax() <= m_yMax);
+  auto centerX = [](const PackedNode& node)
+  {
+    return node.bounds.xMin + node.bounds.xMax;
+  };
+
+  auto centerY = [](const PackedNode& node)
+  {
+    return node.bounds.yMin + node.bounds.yMax;
+  };
+
+  const int nodeCount = (end - begin + NodeCapacity - 1) / NodeCapacity;
+  const int sliceCount = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(nodeCount))));
+  const int sliceSize = sliceCount * NodeCapacity;
+
+  std::sort(m_nodes.begin() + begin, m_nodes.begin() + end, [&centerX](const PackedNode& a, const PackedNode& b)
+  {
+    return centerX(a) < centerX(b);
+  });
+
+  for (int sliceBegin = begin; sliceBegin < end; sliceBegin += sliceSize)
+  {
+    const int sliceEnd = std::min(end, sliceBegin + sliceSize);
+    std::sort(m_nodes.begin() + sliceBegin, m_nodes.begin() + sliceEnd, [&centerY](const PackedNode& a, const PackedNode& b)
+    {
+      return centerY(a) < centerY(b);
+    });
+  }
 }
 
 /*!
   \internal
+
+  Fills \a results with the ids of all elements with bounds intersecting \a bounds.
+  The \a results are cleared first. Each element is stored once, so each id is only reported once.
  */
-bool GeometryQuadtree::QuadTree::intersects(const Envelope& extent) const
+void GeometryQuadtree::PackedRTree::intersectingIds(const Bounds& bounds, QVector<int>& results) const
 {
-  // return whether the supplied extent overlaps this cell
-  return (extent.xMin() < m_xMax &&
-          extent.xMax() > m_xMin &&
-          extent.yMin() < m_yMax &&
-          extent.yMax() > m_yMin);
+  results.clear();
+  if (m_root < 0)
+    return;
+
+  m_stack.clear();
+  m_stack.push_back(m_root);
+  while (!m_stack.empty())
+  {
+    const int index = m_stack.back();
+    m_stack.pop_back();
+
+    const PackedNode& node = m_nodes[index];
+    if (!QuadTree::intersects(node.bounds, bounds))
+      continue;
+
+    if (index < m_entryCount)
+    {
+      results.append(node.first);
+      continue;
+    }
+
+    for (int child = node.first; child < node.first + node.count; ++child)
+      m_stack.push_back(child);
+  }
 }
 
 /*!
   \internal
+
+  Fills \a results with up to \a count entries nearest to (\a lon, \a lat), ordered by distance.
+
+  The search is best-first, in the same way as \l QuadTree::nearest.
  */
-bool GeometryQuadtree::QuadTree::intersects(const Point& location) const
+template <typename EntryDistance>
+void GeometryQuadtree::PackedRTree::nearest(double lon, double lat, int count, double maxDistance,
+                                            EntryDistance&& entryDistance, QVector<QuadTree::SearchResult>& results) const
 {
-  // return whether the supplied location lies within this cell
-  return (location.x() <= m_xMax &&
-          location.x() >= m_xMin &&
-          location.y() <= m_yMax &&
-          location.y() >= m_yMin);
-}
+  results.clear();
+  if (m_root < 0)
+    return;
 
-void GeometryQuadtree::QuadTree::removeId(int index)
-{
-  if (m_geometryIds.remove(index))
+  m_searchQueue.clear();
+  auto compare = [](const QuadTree::SearchItem& a, const QuadTree::SearchItem& b)
   {
-    if (m_tl)
-      m_tl->removeId(index);
+    return a.distance > b.distance;
+  };
 
-    if (m_tr)
-      m_tr->removeId(index);
+  auto push = [this, maxDistance, &compare](double distance, int index, QuadTree::SearchItemType type)
+  {
+    if (distance > maxDistance)
+      return;
+
+    QuadTree::SearchItem item;
+    item.distance = distance;
+    item.index = index;
+    item.type = type;
+    m_searchQueue.push_back(item);
+    std::push_heap(m_searchQueue.begin(), m_searchQueue.end(), compare);
+  };
+
+  // entries are queued by the id of their element, and nodes by their index
+  auto pushNode = [this, lon, lat, &push](int index)
+  {
+    const PackedNode& node = m_nodes[index];
+    const double distance = GeodesicUtils::distanceToBounds(lon, lat, node.bounds.xMin, node.bounds.yMin, node.bounds.xMax, node.bounds.yMax);
+    if (index < m_entryCount)
+      push(distance, node.first, QuadTree::SearchItemType::Entry);
+    else
+      push(distance, index, QuadTree::SearchItemType::Node);
+  };
 
-    if (m_bl)
-      m_bl->removeId(index);
+  pushNode(m_root);
 
-    if (m_br)
-      m_br->removeId(index);
+  while (!m_searchQueue.empty())
+  {
+    std::pop_heap(m_searchQueue.begin(), m_searchQueue.end(), compare);
+    const QuadTree::SearchItem item = m_searchQueue.back();
+    m_searchQueue.pop_back();
+
+    switch (item.type)
+    {
+    case QuadTree::SearchItemType::Result:
+    {
+      // nothing left in the queue can be closer than this
+      QuadTree::SearchResult result;
+      result.id = item.index;
+      result.distance = item.distance;
+      results.append(result);
+      if (results.size() >= count)
+        return;
+
+      break;
+    }
+    case QuadTree::SearchItemType::Entry:
+    {
+      const double distance = entryDistance(item.index);
+      if (distance >= 0.0)
+        push(distance, item.index, QuadTree::SearchItemType::Result);
+
+      break;
+    }
+    case QuadTree::SearchItemType::Node:
+    {
+      const PackedNode& node = m_nodes[item.index];
+      for (int child = node.first; child < node.first + node.count; ++child)
+        pushNode(child);
+
+      break;
+    }
+    }
   }
 }
 
@@ -663,3 +1527,11 @@ void GeometryQuadtree::QuadTree::removeId(int index)
   \brief Signal emitted when the quad tree changes.
  */
 
+/*!
+  \fn void GeometryQuadtree::elementsChanged(const QVector<Dsa::GeometryQuadtree::Bounds>& changedBounds);
+  \brief Signal emitted when elements are added to, changed in or removed from the quad tree.
+
+  \a changedBounds lists the WGS84 bounds of each changed element before and after the change, so
+  that areas which are not listed are unaffected. It is emitted before \l treeChanged, and is not
+  emitted when the tree is built.
+ */
@@ -17,19 +17,30 @@
 #ifndef GEOMETRYQUADTREE_H
 #define GEOMETRYQUADTREE_H
 
+// dsa app headers
+#include "GeodesicUtils.h"
+#include "PreparedPolygon.h"
+
+// C++ API headers
+#include "Geometry.h"
+
 // Qt headers
 #include <QHash>
 #include <QList>
 #include <QObject>
+#include <QVector>
 
 // STL headers
+#include <limits>
 #include <memory>
+#include <utility>
+
+class QTimer;
 
 namespace Esri {
 namespace ArcGISRuntime {
 class Envelope;
 class GeoElement;
-class Geometry;
 class Point;
 }
 }
@@ -43,6 +54,21 @@ class GeometryQuadtree : public QObject
   Q_OBJECT
 
 public:
+  struct Bounds
+  {
+    double xMin = 0.0;
+    double yMin = 0.0;
+    double xMax = 0.0;
+    double yMax = 0.0;
+  };
+
+  struct Neighbour
+  {
+    Esri::ArcGISRuntime::GeoElement* geoElement = nullptr;
+    Esri::ArcGISRuntime::Geometry wgs84Geometry;
+    double distance = 0.0; // in meters
+  };
+
   GeometryQuadtree(const Esri::ArcGISRuntime::Envelope& extent,
                    const QList<Esri::ArcGISRuntime::GeoElement*>& geoElements,
                    int maxLevels,
@@ -50,27 +76,172 @@ public:
   ~GeometryQuadtree();
 
   void appendGeoElment(Esri::ArcGISRuntime::GeoElement* newGeoElement);
+  void appendGeoElements(const QList<Esri::ArcGISRuntime::GeoElement*>& newGeoElements);
+  void removeGeoElement(Esri::ArcGISRuntime::GeoElement* geoElement);
+
+  int staticIndexDelay() const;
+  void setStaticIndexDelay(int msecs);
+  bool isStaticIndexActive() const;
 
   QList<Esri::ArcGISRuntime::Geometry> candidateIntersections(const Esri::ArcGISRuntime::Geometry& geometry) const;
   QList<Esri::ArcGISRuntime::Geometry> candidateIntersections(const Esri::ArcGISRuntime::Envelope& extent) const;
   QList<Esri::ArcGISRuntime::Geometry> candidateIntersections(const Esri::ArcGISRuntime::Point& location) const;
 
+  QList<Neighbour> nearestNeighbours(const Esri::ArcGISRuntime::Point& location,
+                                    int count,
+                                    double maxDistance = std::numeric_limits<double>::max(),
+                                    double localFrameTolerance = -1.0) const;
+  QList<Neighbour> withinDistance(const Esri::ArcGISRuntime::Point& location, double distance, double localFrameTolerance = -1.0) const;
+
+  template <typename Visitor>
+  void visitCandidates(const Bounds& wgs84Bounds, Visitor&& visitor) const;
+
+  template <typename Visitor>
+  void visitCandidates(const Esri::ArcGISRuntime::Envelope& extent, Visitor&& visitor) const;
+
+  template <typename Visitor>
+  void visitPolygonCandidates(const Esri::ArcGISRuntime::Envelope& extent, Visitor&& visitor) const;
+
+  static bool toBounds(const Esri::ArcGISRuntime::Envelope& wgs84Extent, Bounds& bounds);
+  static bool toWgs84Bounds(const Esri::ArcGISRuntime::Envelope& extent, Bounds& bounds);
+
 signals:
   void treeChanged();
+  void elementsChanged(const QVector<Dsa::GeometryQuadtree::Bounds>& changedBounds);
 
 private:
+  struct Element
+  {
+    GeoElementSignaler* signaler = nullptr;
+    Esri::ArcGISRuntime::GeoElement* geoElement = nullptr;
+    Esri::ArcGISRuntime::Geometry geometry; // cached WGS84 geometry
+    GeodesicUtils::PackedGeometry packed; // cached WGS84 coordinates (not populated for polygons)
+    mutable std::shared_ptr<const PreparedPolygon> prepared; // created on demand for polygons
+    Bounds bounds; // cached WGS84 bounds
+    bool indexed = false;
+    bool dirty = false;
+    mutable unsigned int queryStamp = 0;
+  };
+
   void buildTree(const Esri::ArcGISRuntime::Envelope& extent);
-  void handleGeometryChange(int changedIndex);
+  void handleGeometryChange(int changedId);
+  void handleElementRemoved(int removedId);
+  void scheduleFlush();
+  void flushChanges();
+  void flushPendingChanges() const;
+  void reindexElement(int id, Element& element);
   int handleNewGeoElement(Esri::ArcGISRuntime::GeoElement* geoElement);
+  QList<Esri::ArcGISRuntime::Geometry> geometriesFor(const Bounds& wgs84Bounds) const;
+  const QVector<int>& candidateIds(const Bounds& wgs84Bounds) const;
+  void handleTreeModified();
+  void buildStaticIndex();
 
   struct QuadTree;
+  struct PackedRTree;
 
   int m_maxLevels;
   std::unique_ptr<QuadTree> m_tree;
-  QHash<int, GeoElementSignaler*> m_elementStorage;
+  std::unique_ptr<PackedRTree> m_packedTree; // only built once the elements have not changed for a while
+  QTimer* m_staticIndexTimer = nullptr;
+  int m_staticIndexDelay = -1;
+  QHash<int, Element> m_elementStorage;
+  QHash<Esri::ArcGISRuntime::GeoElement*, int> m_elementKeys;
+  QVector<int> m_dirtyIds;
+  QVector<Bounds> m_changedBounds; // the WGS84 bounds, before and after, of elements changed since the last signal
+  bool m_flushScheduled = false;
+  bool m_changePending = false;
+  mutable QVector<int> m_queryResults;
+  mutable unsigned int m_queryStamp = 0;
   int m_nextKey = 0;
 };
 
+/*!
+  \brief Calls \a visitor for each element with WGS84 bounds which intersect \a wgs84Bounds.
+
+  The visitor is called with the cached WGS84 \l Esri::ArcGISRuntime::Geometry and \l Bounds of
+  the element and should return \c false to stop the traversal. No geometry is projected or copied
+  and the results are not collected into a container.
+
+  \note No intersection test is carried out between the supplied bounds and the geometry.
+ */
+template <typename Visitor>
+void GeometryQuadtree::visitCandidates(const Bounds& wgs84Bounds, Visitor&& visitor) const
+{
+  // take the shared buffer for the visit, so a visitor which queries the tree again cannot overwrite it
+  candidateIds(wgs84Bounds);
+  QVector<int> ids;
+  ids.swap(m_queryResults);
+
+  for (const int id : qAsConst(ids))
+  {
+    auto findIt = m_elementStorage.constFind(id);
+    if (findIt == m_elementStorage.constEnd())
+      continue;
+
+    if (!visitor(findIt.value().geometry, findIt.value().bounds))
+      break;
+  }
+
+  m_queryResults.swap(ids);
+}
+
+/*!
+  \brief Calls \a visitor for each element with WGS84 bounds which intersect \a extent.
+
+  \a extent is only projected if it is not already in WGS84.
+
+  \sa visitCandidates
+ */
+template <typename Visitor>
+void GeometryQuadtree::visitCandidates(const Esri::ArcGISRuntime::Envelope& extent, Visitor&& visitor) const
+{
+  Bounds wgs84Bounds;
+  if (toWgs84Bounds(extent, wgs84Bounds))
+    visitCandidates(wgs84Bounds, std::forward<Visitor>(visitor));
+}
+
+/*!
+  \brief Calls \a visitor with the \l PreparedPolygon of each polygon element with WGS84 bounds
+  which intersect \a extent.
+
+  The prepared polygon of an element is created the first time it is visited, and is kept until
+  the geometry of the element changes. Elements which are not polygons are skipped. The visitor
+  should return \c false to stop the traversal.
+
+  \sa visitCandidates
+ */
+template <typename Visitor>
+void GeometryQuadtree::visitPolygonCandidates(const Esri::ArcGISRuntime::Envelope& extent, Visitor&& visitor) const
+{
+  Bounds wgs84Bounds;
+  if (!toWgs84Bounds(extent, wgs84Bounds))
+    return;
+
+  // as in visitCandidates, the shared buffer is taken for the visit and handed back afterwards
+  candidateIds(wgs84Bounds);
+  QVector<int> ids;
+  ids.swap(m_queryResults);
+
+  for (const int id : qAsConst(ids))
+  {
+    auto findIt = m_elementStorage.constFind(id);
+    if (findIt == m_elementStorage.constEnd())
+      continue;
+
+    const Element& element = findIt.value();
+    if (element.geometry.geometryType() != Esri::ArcGISRuntime::GeometryType::Polygon)
+      continue;
+
+    if (!element.prepared)
+      element.prepared = PreparedPolygon::create(element.geometry);
+
+    if (element.prepared && !visitor(element.prepared))
+      break;
+  }
+
+  m_queryResults.swap(ids);
+}
+
 } // Dsa
 
 #endif // GEOMETRYQUADTREE_H
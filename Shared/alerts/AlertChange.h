@@ -0,0 +1,41 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALERTCHANGE_H
+#define ALERTCHANGE_H
+
+// Qt headers
+#include <QFlags>
+
+namespace Dsa {
+
+// the kinds of change reported by an AlertSource or AlertTarget
+enum class AlertChange : unsigned int
+{
+  None = 0x0,
+  Geometry = 0x1,
+  Attributes = 0x2,
+  Validity = 0x4,
+  All = Geometry | Attributes | Validity
+};
+
+Q_DECLARE_FLAGS(AlertChanges, AlertChange)
+
+} // Dsa
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Dsa::AlertChanges)
+
+#endif // ALERTCHANGE_H
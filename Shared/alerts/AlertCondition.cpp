@@ -21,11 +21,26 @@
 
 // dsa app headers
 #include "AlertConditionData.h"
+#include "AlertScheduler.h"
+#include "AlertTarget.h"
+#include "GeodesicUtils.h"
 #include "GraphicAlertSource.h"
 
 // C++ API headers
 #include "GraphicListModel.h"
 #include "GraphicsOverlay.h"
+#include "Point.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
+#include <QThreadPool>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <memory>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -41,11 +56,32 @@ namespace Dsa {
   An AlertCondition is made up of an \l AlertSource (generally some form of real-time feed)
   a query and an \l AlertTarget (a real time feed or an overlay).
 
-  The condition is applied to all source objects, creating an \l AlertConditionData for each.
+  The condition is applied to all source objects. The state of each source is kept in flat
+  arrays owned by the condition, and an \l AlertConditionData is only created for a source while
+  it matches the query. Condition data which stops matching is deleted, keeping its ID so that it is
+  re-used if the source matches again. This means that large source feeds only create objects and
+  connections for the alerts which are active.
 
   When either the source or target is changed for a given data element, the condition can be
   re-tested using an \l AlertQuery to determine whether an elert should be triggered.
 
+  Changes are not evaluated immediately. The condition records which sources and targets have changed
+  and evaluates all of the affected sources in a single pass, when scheduled by the \l AlertScheduler.
+  Types implement \l createEvaluation to test many sources against a target at once (e.g. using
+  \l AlertSpatialJoin).
+
+  A spatial evaluation can also report the \e slack of each source: how far it can move before
+  the result could change. Movement of a source which stays within its slack, measured from the
+  location which was evaluated, is not re-evaluated. A change to the target resets the slacks of
+  the sources it can affect.
+
+  When the target reports that its geometry changed only within some areas (see
+  \l AlertTarget::geometryChangedInAreas) and the condition has a \l targetInfluenceDistance, only the
+  sources near to those areas are re-evaluated. The locations at which sources were evaluated are
+  kept in a \l SpatialHashGrid, with cells sized to the influence distance, so that the affected
+  sources are found by visiting the neighbouring cells. Only sources which moved beyond their slack
+  are moved in the grid.
+
   \note This is an abstract base type.
 
   \sa AlertSource
@@ -70,8 +106,7 @@ AlertCondition::AlertCondition(const AlertLevel& level,
 /*!
   \brief Initializes the condition with a \a source and \a target with a \a sourceDescription and a \a targetDescription.
 
-  A new \l AlertConditionData will be created to track changes to the
-  source and target.
+  The condition will track changes to the source and target.
  */
 void AlertCondition::init(AlertSource* source, AlertTarget* target, const QString& sourceDescription, const QString& targetDescription)
 {
@@ -80,15 +115,15 @@ void AlertCondition::init(AlertSource* source, AlertTarget* target, const QStrin
 
   m_sourceDescription = sourceDescription;
   m_targetDescription = targetDescription;
-  AlertConditionData* newData = createData(source, target);
-  addData(newData);
+  setTarget(target);
+  addSource(source);
 }
 
 /*!
   \brief Initializes the condition with a \a sourceFeed, \a sourceDescription, a \a target and a \a targetDescription.
 
-  A new \l AlertConditionData will be created for each \l Esri::ArcGISRuntime::Graphic
-  in the source feed, to track changes to the source and target.
+  Each \l Esri::ArcGISRuntime::Graphic in the source feed is tracked as a source, using the
+  \l GraphicAlertSource which is shared by every condition using the graphic.
  */
 void AlertCondition::init(GraphicsOverlay* sourceFeed, const QString& sourceDescription, AlertTarget* target, const QString& targetDescription)
 {
@@ -97,13 +132,14 @@ void AlertCondition::init(GraphicsOverlay* sourceFeed, const QString& sourceDesc
 
   m_sourceDescription = sourceDescription;
   m_targetDescription = targetDescription;
+  setTarget(target);
 
   GraphicListModel* graphics = sourceFeed->graphics();
   if (!graphics)
     return;
 
-  // process a new graphic from the source feed to create a new AlertConditionData
-  auto handleGraphicAt = [this, graphics, target](int index)
+  // process a new graphic from the source feed to track it as a source
+  auto handleGraphicAt = [this, graphics](int index)
   {
     if (!graphics)
       return;
@@ -112,16 +148,17 @@ void AlertCondition::init(GraphicsOverlay* sourceFeed, const QString& sourceDesc
     if (!newGraphic)
       return;
 
-    GraphicAlertSource* source = new GraphicAlertSource(newGraphic);
-    AlertConditionData* newData = createData(source, target);
-    addData(newData);
+    addSource(GraphicAlertSource::sourceFor(newGraphic));
   };
 
-  // connect to the graphicAdded to add condition data for any new graphics
+  // connect to the graphicAdded to track any new graphics
   connect(graphics, &GraphicListModel::itemAdded, this, handleGraphicAt);
 
-  // add condition data for all of the graphics which are in the overlay to begin with
+  // track all of the graphics which are in the overlay to begin with
   const int count = graphics->rowCount();
+  m_sources.reserve(count);
+  m_states.reserve(count);
+  m_data.reserve(count);
   for (int i = 0; i < count; ++i)
     handleGraphicAt(i);
 }
@@ -131,6 +168,7 @@ void AlertCondition::init(GraphicsOverlay* sourceFeed, const QString& sourceDesc
  */
 AlertCondition::~AlertCondition()
 {
+  AlertScheduler::instance()->cancelEvaluation(this);
   emit noLongerValid();
 }
 
@@ -152,9 +190,8 @@ void AlertCondition::setLevel(AlertLevel level)
 
   m_level = level;
 
-  for (auto it = m_data.begin(); it != m_data.end(); ++it)
+  for (AlertConditionData* data : qAsConst(m_data))
   {
-    AlertConditionData* data = *it;
     if (data)
       data->setLevel(m_level);
   }
@@ -184,32 +221,94 @@ void AlertCondition::setName(const QString& name)
   {
     AlertConditionData* data = m_data.at(i);
     if (data)
-      data->setName(m_name + QString(" (%1)").arg(QString::number(i)));
+      data->setName(newConditionDataName(m_sources.at(i)));
   }
 
   emit conditionChanged();
 }
 
 /*!
-  \brief Returns a name for the next new condition data.
+  \brief Returns a name for new condition data for \a source.
+
+  The number is assigned when the source is added to the condition and is never reused, so the
+  names of condition data are unique for the lifetime of the condition.
 
   \note This will be of the form "My Condition (1)".
  */
-QString AlertCondition::newConditionDataName() const
+QString AlertCondition::newConditionDataName(AlertSource* source) const
 {
-  return m_name + QString(" (%1)").arg(QString::number(m_data.count()));
+  auto findIt = m_rows.constFind(source);
+  const int number = findIt != m_rows.cend() ? m_sourceNumbers.at(findIt.value()) : m_nextSourceNumber;
+  return m_name + QString(" (%1)").arg(QString::number(number));
 }
 
 /*!
-  \brief Appends \a newData to the list of data being tracked for this condition.
+  \brief Returns the kinds of change to the sources or target which can affect the result of the query.
+
+  Changes to validity always affect the query. The default implementation returns \c AlertChange::All.
  */
-void AlertCondition::addData(AlertConditionData* newData)
+AlertChanges AlertCondition::dependencies() const
 {
-  if (!newData)
-    return;
+  return AlertChange::All;
+}
+
+/*!
+  \brief Returns the names of the source attributes which the query uses.
+
+  An empty list (the default) means that a change to any attribute may affect the query.
+ */
+QStringList AlertCondition::attributeDependencies() const
+{
+  return QStringList();
+}
+
+/*!
+  \brief Returns the distance, in meters, within which a change to the geometry of the target can
+  affect a source, measured from the location at which the source was last evaluated.
+
+  A change to the target which is further than this from a source does not affect its result or
+  its slack. The default implementation returns \c -1, meaning that any change to the target can
+  affect every source.
 
-  m_data.append(newData);
-  emit newConditionData(newData);
+  Types which return a distance must report the location of each source (and its slack) in their
+  \l EvaluationResults.
+ */
+double AlertCondition::targetInfluenceDistance() const
+{
+  return -1.0;
+}
+
+/*!
+  \brief Returns whether the \a changes to a source or target can affect the result of the query.
+
+  If the \a changes are limited to attributes, they only affect the query when one of the
+  \a changedKeys is in the \l attributeDependencies. An empty list of \a changedKeys means that
+  any attribute may have changed.
+ */
+bool AlertCondition::dependsOn(AlertChanges changes, const QStringList& changedKeys) const
+{
+  if (changes.testFlag(AlertChange::Validity))
+    return true;
+
+  const AlertChanges relevantChanges = changes & dependencies();
+  if (!relevantChanges)
+    return false;
+
+  // any relevant change other than to attributes affects the query
+  if (relevantChanges != AlertChanges(AlertChange::Attributes))
+    return true;
+
+  const QStringList keys = attributeDependencies();
+  if (keys.isEmpty() || changedKeys.isEmpty())
+    return true;
+
+  for (const QString& key : keys)
+  {
+    if (changedKeys.contains(key))
+      return true;
+  }
+
+  return false;
 }
 
 /*!
@@ -250,34 +349,606 @@ bool AlertCondition::isConditionEnabled() const
   \brief Sets this condition to be \a enabled.
 
   When enabled is \c false the condition will not be checked and no alerts will be raised.
+  Changes made while the condition was disabled are evaluated when it is enabled again.
  */
 void AlertCondition::setConditionEnabled(bool enabled)
 {
   if (enabled == m_enabled)
     return;
 
-  for (auto it = m_data.cbegin(); it != m_data.cend(); ++it)
+  for (AlertConditionData* data : qAsConst(m_data))
   {
-    AlertConditionData* data = *it;
     if (data)
       data->setConditionEnabled(enabled);
   }
 
   m_enabled = enabled;
+
+  if (m_enabled && !m_sources.isEmpty())
+  {
+    m_pendingTargetChanges |= AlertChange::All;
+    scheduleEvaluation();
+  }
+
   emit conditionEnabledChanged();
 }
 
+/*!
+  \brief Returns the number of sources tracked by this condition, whether or not they match the query.
+ */
+int AlertCondition::sourceCount() const
+{
+  return m_sources.count();
+}
+
+/*!
+  \brief Returns whether there are changes to this condition's sources which have not yet been evaluated.
+ */
+bool AlertCondition::hasPendingData() const
+{
+  return !m_pendingSources.isEmpty() || m_pendingTargetChanges;
+}
+
+/*!
+  \brief Evaluates the sources affected by the pending changes and applies the results.
+
+  An \l AlertConditionData is created for each source which now matches the query, and is
+  deleted for each source which no longer matches it.
+
+  Evaluation stops once \a elapsed exceeds \a budget milliseconds. Sources which have not been
+  evaluated remain pending.
+
+  If the \l AlertScheduler is concurrent, only the snapshots are taken here and the evaluations
+  are run on the global QThreadPool.
+
+  Returns \c true if all of the pending sources were evaluated.
+ */
+bool AlertCondition::evaluatePendingData(const QElapsedTimer& elapsed, qint64 budget)
+{
+  // the maximum number of sources to evaluate between checks of the budget
+  constexpr int chunkSize = 256;
+
+  if (!m_enabled || !m_target)
+  {
+    m_pendingSources.clear();
+    m_pendingTargetChanges = AlertChange::None;
+    return true;
+  }
+
+  // every source needs to be re-evaluated against a changed target
+  if (m_pendingTargetChanges)
+  {
+    const int count = m_sources.count();
+    for (int row = 0; row < count; ++row)
+    {
+      invalidateRow(row);
+      m_pendingSources.insert(m_sources.at(row));
+    }
+
+    m_pendingTargetChanges = AlertChange::None;
+  }
+
+  QList<AlertSource*> batch;
+  batch.reserve(m_pendingSources.size());
+  for (AlertSource* source : qAsConst(m_pendingSources))
+  {
+    auto findIt = m_rows.constFind(source);
+    if (findIt == m_rows.cend() || !(m_states.at(findIt.value()) & OutOfDate))
+      continue;
+
+    batch.append(source);
+  }
+
+  m_pendingSources.clear();
+
+  EvaluationResults results;
+  bool complete = true;
+  for (int start = 0; start < batch.size(); start += chunkSize)
+  {
+    const QList<AlertSource*> chunk = batch.mid(start, chunkSize);
+
+    // once the budget is spent, leave the rest of the sources for the next evaluation. At least
+    // one chunk is always evaluated so that progress is made
+    if (!complete || (start > 0 && elapsed.elapsed() >= budget))
+    {
+      complete = false;
+      for (AlertSource* source : chunk)
+        m_pendingSources.insert(source);
+
+      continue;
+    }
+
+    const Evaluation evaluation = createEvaluation(m_target, chunk);
+
+    // in concurrent mode the evaluation runs on the thread pool and only the results come back
+    if (AlertScheduler::instance()->isConcurrent())
+    {
+      submitEvaluation(chunk, evaluation);
+      continue;
+    }
+
+    results = EvaluationResults();
+    evaluation(results);
+    applyResults(chunk, results, 0);
+  }
+
+  return complete;
+}
+
+/*!
+  \brief Fills \a lons and \a lats with the WGS84 coordinates of the location of each of the \a sources.
+
+  Empty locations are given \c NaN coordinates.
+ */
+void AlertCondition::wgs84SourceLocations(const QList<AlertSource*>& sources, QVector<double>& lons, QVector<double>& lats)
+{
+  const int count = sources.size();
+  lons.resize(count);
+  lats.resize(count);
+  for (int i = 0; i < count; ++i)
+  {
+    const Point wgs84 = sources.at(i)->wgs84Location();
+    lons[i] = wgs84.isEmpty() ? std::nan("") : wgs84.x();
+    lats[i] = wgs84.isEmpty() ? std::nan("") : wgs84.y();
+  }
+}
+
+/*!
+  \internal
+
+  Sets the \a target which every source is tested against, and tracks changes to it.
+ */
+void AlertCondition::setTarget(AlertTarget* target)
+{
+  if (m_target == target)
+    return;
+
+  if (m_target)
+    disconnect(m_target, nullptr, this, nullptr);
+
+  m_target = target;
+  invalidateTargetCaches(AlertChange::All);
+
+  const double influenceDistance = targetInfluenceDistance();
+  if (influenceDistance >= 0.0)
+    m_sourceGrid.setCellSize(influenceDistance);
+
+  connect(m_target, &AlertTarget::dataChanged, this, &AlertCondition::handleTargetChanged);
+  connect(m_target, &AlertTarget::geometryChangedInAreas, this, &AlertCondition::handleTargetAreasChanged);
+
+  // a condition without its target can never be met
+  connect(m_target, &AlertTarget::noLongerValid, this, &AlertCondition::noLongerValid);
+  connect(m_target, &AlertTarget::destroyed, this, [this]()
+  {
+    m_target = nullptr;
+    m_pendingTargetChanges = AlertChange::None;
+    invalidateTargetCaches(AlertChange::All);
+  });
+}
+
+/*!
+  \internal
+
+  Adds a row for \a source and schedules its evaluation.
+ */
+void AlertCondition::addSource(AlertSource* source)
+{
+  if (!source || m_rows.contains(source))
+    return;
+
+  m_rows.insert(source, m_sources.count());
+  m_sources.append(source);
+  m_states.append(OutOfDate);
+  m_data.append(nullptr);
+  m_slacks.append(0.0);
+  m_slackLons.append(0.0);
+  m_slackLats.append(0.0);
+  m_sourceNumbers.append(m_nextSourceNumber++);
+
+  connect(source, &AlertSource::dataChanged, this, [this, source](AlertChanges changes, const QStringList& changedKeys)
+  {
+    handleSourceChanged(source, changes, changedKeys);
+  });
+
+  connect(source, &AlertSource::destroyed, this, [this, source]()
+  {
+    removeSource(source);
+  });
+
+  m_pendingSources.insert(source);
+  scheduleEvaluation();
+}
+
+/*!
+  \internal
+
+  Removes the row for \a source, deleting any condition data for it. The last row is moved
+  into its place.
+ */
+void AlertCondition::removeSource(AlertSource* source)
+{
+  auto findIt = m_rows.find(source);
+  if (findIt == m_rows.end())
+    return;
+
+  const int row = findIt.value();
+  m_rows.erase(findIt);
+  m_sourceGrid.remove(source);
+  disconnect(source, nullptr, this, nullptr);
+
+  // the source may be being destroyed, so the data is deleted without updating its state
+  AlertConditionData* data = m_data.at(row);
+  if (data)
+  {
+    disconnect(data, nullptr, this, nullptr);
+    delete data;
+  }
+
+  const int lastRow = m_sources.count() - 1;
+  if (row != lastRow)
+  {
+    m_sources[row] = m_sources.at(lastRow);
+    m_states[row] = m_states.at(lastRow);
+    m_data[row] = m_data.at(lastRow);
+    m_slacks[row] = m_slacks.at(lastRow);
+    m_slackLons[row] = m_slackLons.at(lastRow);
+    m_slackLats[row] = m_slackLats.at(lastRow);
+    m_sourceNumbers[row] = m_sourceNumbers.at(lastRow);
+    m_rows[m_sources.at(row)] = row;
+  }
+
+  m_sources.removeLast();
+  m_states.removeLast();
+  m_data.removeLast();
+  m_slacks.removeLast();
+  m_slackLons.removeLast();
+  m_slackLats.removeLast();
+  m_sourceNumbers.removeLast();
+
+  m_pendingSources.remove(source);
+  m_evaluationIds.remove(source);
+  m_releasedData.remove(source);
+}
+
+/*!
+  \internal
+
+  Flags the query for \a row as out-of-date.
+ */
+void AlertCondition::invalidateRow(int row)
+{
+  m_states[row] |= OutOfDate;
+  m_slacks[row] = 0.0;
+
+  AlertConditionData* data = m_data.at(row);
+  if (data)
+    data->invalidateQuery();
+}
+
+/*!
+  \internal
+
+  Records the \a changes to \a source, where \a changedKeys are the names of any changed attributes,
+  and schedules an evaluation.
+
+  Changes which the query does not depend on are ignored, as is movement of the source which is
+  within the slack of its last evaluation.
+ */
+void AlertCondition::handleSourceChanged(AlertSource* source, AlertChanges changes, const QStringList& changedKeys)
+{
+  if (!m_enabled || !dependsOn(changes, changedKeys))
+    return;
+
+  auto findIt = m_rows.constFind(source);
+  if (findIt == m_rows.cend())
+    return;
+
+  const int row = findIt.value();
+  const AlertChanges otherChanges = changes & ~AlertChanges(AlertChange::Geometry);
+  if (changes.testFlag(AlertChange::Geometry) && !dependsOn(otherChanges, changedKeys) && isWithinSlack(row))
+    return;
+
+  invalidateRow(row);
+  m_pendingSources.insert(source);
+  scheduleEvaluation();
+}
+
+/*!
+  \brief Called when the target reports \a changes, before any evaluation is scheduled.
+
+  Types which cache values derived from the target should discard them here. The default
+  implementation does nothing.
+ */
+void AlertCondition::invalidateTargetCaches(AlertChanges)
+{
+}
+
+/*!
+  \internal
+
+  Records the \a changes to the target and schedules an evaluation of every source.
+
+  Changes which the query does not depend on are ignored.
+ */
+void AlertCondition::handleTargetChanged(AlertChanges changes)
+{
+  // anything derived from the target is discarded, even while the condition is disabled
+  invalidateTargetCaches(changes);
+
+  if (!m_enabled || !dependsOn(changes))
+    return;
+
+  m_pendingTargetChanges |= changes;
+  scheduleEvaluation();
+}
+
+/*!
+  \internal
+
+  Schedules an evaluation of the sources which can be affected by a change to the geometry of the
+  target within \a wgs84Areas.
+
+  These are the sources last evaluated within the \l targetInfluenceDistance of an area, along
+  with any source whose evaluation is still running, since the location it is being evaluated at
+  is not yet known. If the condition has no influence distance every source is evaluated.
+ */
+void AlertCondition::handleTargetAreasChanged(const QVector<Envelope>& wgs84Areas)
+{
+  if (!m_enabled || !dependsOn(AlertChange::Geometry))
+    return;
+
+  const double influenceDistance = targetInfluenceDistance();
+  if (influenceDistance < 0.0)
+  {
+    handleTargetChanged(AlertChange::Geometry);
+    return;
+  }
+
+  // every source is already being evaluated
+  if (m_pendingTargetChanges)
+    return;
+
+  bool invalidated = false;
+  auto invalidateSource = [this, &invalidated](AlertSource* source)
+  {
+    auto findIt = m_rows.constFind(source);
+    if (findIt == m_rows.cend())
+      return;
+
+    invalidateRow(findIt.value());
+    m_pendingSources.insert(source);
+    invalidated = true;
+  };
+
+  for (auto it = m_evaluationIds.cbegin(); it != m_evaluationIds.cend(); ++it)
+    invalidateSource(it.key());
+
+  for (const Envelope& area : wgs84Areas)
+  {
+    if (area.isEmpty())
+      continue;
+
+    m_sourceGrid.visitNear(area.xMin(), area.yMin(), area.xMax(), area.yMax(), influenceDistance, [&invalidateSource](AlertSource* source, double, double)
+    {
+      invalidateSource(source);
+    });
+  }
+
+  if (invalidated)
+    scheduleEvaluation();
+}
+
+/*!
+  \internal
+
+  Asks the \l AlertScheduler to evaluate the pending changes, so that any further changes
+  made before then are evaluated in the same pass.
+ */
+void AlertCondition::scheduleEvaluation()
+{
+  AlertScheduler::instance()->scheduleEvaluation(this);
+}
+
+/*!
+  \internal
+
+  Runs \a evaluation of \a sources on the global QThreadPool. The results are applied on this
+  object's thread, via the \l AlertScheduler, unless the condition has been deleted.
+ */
+void AlertCondition::submitEvaluation(const QList<AlertSource*>& sources, const Evaluation& evaluation)
+{
+  // record the latest evaluation for each source so that out-of-order results are ignored
+  const quint64 evaluationId = ++m_lastEvaluationId;
+  for (AlertSource* source : sources)
+    m_evaluationIds.insert(source, evaluationId);
+
+  // the task is shared between this thread and the worker, which only touches the evaluation and results
+  struct EvaluationTask
+  {
+    QPointer<AlertCondition> condition;
+    QList<AlertSource*> sources;
+    Evaluation evaluation;
+    EvaluationResults results;
+    quint64 evaluationId = 0;
+  };
+
+  auto task = std::make_shared<EvaluationTask>();
+  task->condition = this;
+  task->sources = sources;
+  task->evaluation = evaluation;
+  task->evaluationId = evaluationId;
+
+  QThreadPool::globalInstance()->start([task]()
+  {
+    task->evaluation(task->results);
+
+    QMetaObject::invokeMethod(AlertScheduler::instance(), [task]()
+    {
+      if (task->condition)
+        task->condition->applyResults(task->sources, task->results, task->evaluationId);
+    }, Qt::QueuedConnection);
+  });
+}
+
+/*!
+  \internal
+
+  Applies the \a results of evaluation \a evaluationId to the rows for \a sources, along with
+  the slack of each source if the evaluation measured it.
+
+  Results from a concurrent evaluation are discarded for sources which have since changed or been
+  removed, or which have been submitted in a newer evaluation. An \a evaluationId of \c 0 indicates
+  results which were evaluated synchronously.
+ */
+void AlertCondition::applyResults(const QList<AlertSource*>& sources, const EvaluationResults& results, quint64 evaluationId)
+{
+  const int count = std::min(sources.size(), results.matches.size());
+  const bool hasSlacks = results.slacks.size() >= count && results.lons.size() >= count && results.lats.size() >= count;
+  for (int i = 0; i < count; ++i)
+  {
+    AlertSource* source = sources.at(i);
+    auto findIt = m_evaluationIds.find(source);
+    if (evaluationId == 0)
+    {
+      // synchronous results replace those of any evaluation which is still running
+      if (findIt != m_evaluationIds.end())
+        m_evaluationIds.erase(findIt);
+    }
+    else
+    {
+      if (findIt == m_evaluationIds.end() || findIt.value() != evaluationId)
+        continue;
+
+      m_evaluationIds.erase(findIt);
+
+      if (m_pendingSources.contains(source) || m_pendingTargetChanges)
+        continue;
+    }
+
+    auto rowIt = m_rows.constFind(source);
+    if (rowIt == m_rows.cend())
+      continue;
+
+    const int row = rowIt.value();
+    setRowResult(row, results.matches.at(i));
+
+    if (hasSlacks)
+    {
+      m_slacks[row] = results.slacks.at(i);
+      m_slackLons[row] = results.lons.at(i);
+      m_slackLats[row] = results.lats.at(i);
+
+      // the source is only moved to another cell of the grid if it has moved that far
+      if (std::isnan(results.lons.at(i)) || std::isnan(results.lats.at(i)))
+        m_sourceGrid.remove(source);
+      else
+        m_sourceGrid.insert(source, results.lons.at(i), results.lats.at(i));
+    }
+  }
+}
+
+/*!
+  \internal
+
+  Returns whether the source at \a row is still within the slack of its last evaluation: that is,
+  it has moved less than the distance which could change the result.
+
+  The distance is measured from the location which was evaluated, so that small movements
+  accumulate until the source has moved far enough to be evaluated again.
+ */
+bool AlertCondition::isWithinSlack(int row) const
+{
+  if ((m_states.at(row) & OutOfDate) || m_slacks.at(row) <= 0.0)
+    return false;
+
+  const Point wgs84 = m_sources.at(row)->wgs84Location();
+  if (wgs84.isEmpty())
+    return false;
+
+  return GeodesicUtils::distance(m_slackLons.at(row), m_slackLats.at(row), wgs84.x(), wgs84.y()) < m_slacks.at(row);
+}
+
+/*!
+  \internal
+
+  Stores whether the source at \a row \a matches the query.
+
+  Condition data is created for a source which starts to match, and released for one which stops.
+ */
+void AlertCondition::setRowResult(int row, bool matches)
+{
+  m_states[row] = matches ? Matches : 0;
+
+  AlertConditionData* data = m_data.at(row);
+  if (!matches)
+  {
+    if (data)
+      releaseData(row);
+
+    return;
+  }
+
+  if (data)
+  {
+    data->updateQueryResult(true);
+    return;
+  }
+
+  AlertSource* source = m_sources.at(row);
+  data = createData(source, m_target);
+  if (!data)
+    return;
+
+  m_data[row] = data;
+  data->setConditionEnabled(m_enabled);
+  data->setId(m_releasedData.take(source));
+  data->updateQueryResult(true);
+
+  // the data may also be deleted along with its source or target
+  connect(data, &AlertConditionData::destroyed, this, [this, source, data]()
+  {
+    auto findIt = m_rows.constFind(source);
+    if (findIt != m_rows.cend() && m_data.at(findIt.value()) == data)
+      m_data[findIt.value()] = nullptr;
+  });
+
+  emit newConditionData(data);
+}
+
+/*!
+  \internal
+
+  Deletes the condition data for \a row, keeping its ID in case the source matches again.
+ */
+void AlertCondition::releaseData(int row)
+{
+  AlertConditionData* data = m_data.at(row);
+  if (!data)
+    return;
+
+  m_data[row] = nullptr;
+  disconnect(data, nullptr, this, nullptr);
+
+  if (!data->id().isNull())
+    m_releasedData.insert(m_sources.at(row), data->id());
+
+  // report that the data is no longer active before it is removed from any models
+  data->updateQueryResult(false);
+  delete data;
+}
+
 } // Dsa
 
 // Signal Documentation
 /*!
   \fn void AlertCondition::noLongerValid();
-  \brief Signal emitted when alert condition is no longer valid.
+  \brief Signal emitted when alert condition is no longer valid, either because it is being
+  destroyed or because its target is no longer valid.
  */
 
 /*!
   \fn void AlertCondition::newConditionData(Dsa::AlertConditionData* newConditionData);
-  \brief Signal emitted when \a newConditionData is added to the alert condition.
+  \brief Signal emitted when \a newConditionData is created for a source which matches the condition.
  */
 
 /*!
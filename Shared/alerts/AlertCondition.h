@@ -18,17 +18,30 @@
 #define ALERTCONDITION_H
 
 // dsa app headers
+#include "AlertChange.h"
 #include "AlertLevel.h"
+#include "SpatialHashGrid.h"
 
 // Qt headers
+#include <QHash>
 #include <QList>
 #include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QUuid>
 #include <QVariantMap>
+#include <QVector>
+
+// STL headers
+#include <functional>
+
+class QElapsedTimer;
 
 namespace Esri
 {
 namespace ArcGISRuntime
 {
+class Envelope;
 class GraphicsOverlay;
 }
 }
@@ -59,14 +72,17 @@ public:
   QString name() const;
   void setName(const QString& name);
 
-  QString newConditionDataName() const;
-
-  void addData(AlertConditionData* newData);
+  QString newConditionDataName(AlertSource* source) const;
 
   virtual QString queryString() const = 0;
   virtual QVariantMap queryComponents() const = 0;
   virtual AlertConditionData* createData(AlertSource* source, AlertTarget* target) = 0;
 
+  virtual AlertChanges dependencies() const;
+  virtual QStringList attributeDependencies() const;
+  virtual double targetInfluenceDistance() const;
+  bool dependsOn(AlertChanges changes, const QStringList& changedKeys = QStringList()) const;
+
   QString sourceDescription() const;
   QString targetDescription() const;
   QString description() const;
@@ -74,19 +90,80 @@ public:
   bool isConditionEnabled() const;
   void setConditionEnabled(bool enabled);
 
+  int sourceCount() const;
+  bool hasPendingData() const;
+  bool evaluatePendingData(const QElapsedTimer& elapsed, qint64 budget);
+
 signals:
   void noLongerValid();
   void newConditionData(Dsa::AlertConditionData* newConditionData);
   void conditionChanged();
   void conditionEnabledChanged();
 
+protected:
+  // the results of evaluating a batch of sources, with one element per source
+  struct EvaluationResults
+  {
+    QVector<bool> matches;
+    QVector<double> slacks; // how far, in meters, each source can move before it could change. Empty if not known
+    QVector<double> lons; // the WGS84 locations which the slacks are measured from
+    QVector<double> lats;
+  };
+
+  // evaluates a batch of sources from a snapshot, so that it can be run on any thread
+  using Evaluation = std::function<void(EvaluationResults& results)>;
+
+  virtual Evaluation createEvaluation(AlertTarget* target, const QList<AlertSource*>& sources) const = 0;
+  virtual void invalidateTargetCaches(AlertChanges changes);
+
+  static void wgs84SourceLocations(const QList<AlertSource*>& sources, QVector<double>& lons, QVector<double>& lats);
+
 private:
+  // the state of each source, stored as flags
+  enum SourceState : quint8
+  {
+    OutOfDate = 0x1,
+    Matches = 0x2
+  };
+
+  void setTarget(AlertTarget* target);
+  void addSource(AlertSource* source);
+  void removeSource(AlertSource* source);
+  void invalidateRow(int row);
+  void handleSourceChanged(AlertSource* source, AlertChanges changes, const QStringList& changedKeys);
+  void handleTargetChanged(AlertChanges changes);
+  void handleTargetAreasChanged(const QVector<Esri::ArcGISRuntime::Envelope>& wgs84Areas);
+  void scheduleEvaluation();
+  void submitEvaluation(const QList<AlertSource*>& sources, const Evaluation& evaluation);
+  void applyResults(const QList<AlertSource*>& sources, const EvaluationResults& results, quint64 evaluationId);
+  void setRowResult(int row, bool matches);
+  bool isWithinSlack(int row) const;
+  void releaseData(int row);
+
   bool m_enabled = true;
   AlertLevel m_level;
   QString m_name;
-  QList<AlertConditionData*> m_data;
   QString m_sourceDescription;
   QString m_targetDescription;
+  AlertTarget* m_target = nullptr;
+
+  // one entry per source, indexed by row. Condition data is only created while a source matches the query
+  QVector<AlertSource*> m_sources;
+  QVector<quint8> m_states;
+  QVector<AlertConditionData*> m_data;
+  QVector<double> m_slacks; // in meters, from the location in m_slackLons and m_slackLats
+  QVector<double> m_slackLons;
+  QVector<double> m_slackLats;
+  QVector<int> m_sourceNumbers; // a number for each source which is never reused, used to name its condition data
+  QHash<AlertSource*, int> m_rows;
+  SpatialHashGrid<AlertSource*> m_sourceGrid; // the location at which each source was last evaluated, if it has a slack
+  QHash<AlertSource*, QUuid> m_releasedData; // the IDs of condition data which has been released, so they are kept if it is re-created
+
+  QSet<AlertSource*> m_pendingSources;
+  AlertChanges m_pendingTargetChanges;
+  QHash<AlertSource*, quint64> m_evaluationIds; // the latest evaluation submitted for each source
+  quint64 m_lastEvaluationId = 0;
+  int m_nextSourceNumber = 0;
 };
 
 } // Dsa
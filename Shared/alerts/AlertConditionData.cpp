@@ -77,13 +77,12 @@ AlertConditionData::AlertConditionData(const QString& name,
   m_target(target)
 {
   connect(m_source, &AlertSource::noLongerValid, this, &AlertConditionData::noLongerValid);
-  connect(m_source, &AlertSource::dataChanged, this, &AlertConditionData::handleDataChanged);
   connect(m_source, &AlertSource::destroyed, this, [this]()
   {
     m_source = nullptr;
     emit noLongerValid();
   });
-  connect(m_target, &AlertTarget::dataChanged, this, &AlertConditionData::handleDataChanged);
+  // changes to the source and target are tracked by the AlertCondition, which evaluates the query
   connect(m_target, &AlertTarget::destroyed, this, [this]()
   {
     m_target = nullptr;
@@ -212,6 +211,32 @@ void AlertConditionData::setActive(bool active)
     return;
 
   m_active = active;
+
+  // record the order in which condition data became active, so that alerts can be sorted by recency
+  if (m_active)
+  {
+    static quint64 s_lastActivationOrder = 0;
+    m_activationOrder = ++s_lastActivationOrder;
+  }
+}
+
+/*!
+  \brief Returns a number which orders this condition data by the time it last became active.
+
+  Condition data which became active more recently has a higher value. Returns \c 0 if the
+  condition data has never been active.
+ */
+quint64 AlertConditionData::activationOrder() const
+{
+  return m_activationOrder;
+}
+
+/*!
+  \brief Returns the \l AlertCondition which created this condition data, if any.
+ */
+AlertCondition* AlertConditionData::condition() const
+{
+  return qobject_cast<AlertCondition*>(parent());
 }
 
 /*!
@@ -257,20 +282,26 @@ bool AlertConditionData::isQueryOutOfDate() const
 }
 
 /*!
-  \brief Internal.
+  \brief Flags the query as out-of-date.
 
-  Respond to changes to the underlying source or target data.
+  The query will be re-run the next time the owning \l AlertCondition evaluates its data,
+  or when \l isActive is called.
  */
-void AlertConditionData::handleDataChanged()
+void AlertConditionData::invalidateQuery()
 {
-  if (!isConditionEnabled())
-    return;
-
-  // set the query flag to out-of-date to force a new query to be run
   m_queryOutOfDate = true;
+}
+
+/*!
+  \brief Applies the result of running the query, \a matchesQuery, to this condition data.
 
-  // run the query and cache whether this condition has now been met
-  m_cachedQueryResult = matchesQuery();
+  The owning \l AlertCondition calls this after evaluating a batch of data. If the active state
+  changes, \l dataChanged is emitted.
+ */
+void AlertConditionData::updateQueryResult(bool matchesQuery)
+{
+  // cache whether this condition has now been met
+  m_cachedQueryResult = matchesQuery;
 
   // the query is now up-to-date
   m_queryOutOfDate = false;
@@ -316,9 +347,9 @@ void AlertConditionData::setConditionEnabled(bool enabled)
 
   m_enabled = enabled;
 
-  // if the condition has been re-enabled, we need to re-apply the query to see if it should now become active
+  // if the condition has been re-enabled, the query needs to be re-run to see whether it is still active
   if (enabled)
-    handleDataChanged();
+    invalidateQuery();
   else // make sure we do not highlight inactive conditions
      highlight(false);
 
@@ -332,8 +363,8 @@ void AlertConditionData::setConditionEnabled(bool enabled)
  */
 bool AlertConditionData::isActive() const
 {
-  if (m_queryOutOfDate)
-    const_cast<AlertConditionData*>(this)->handleDataChanged();
+  if (m_queryOutOfDate && isConditionEnabled())
+    const_cast<AlertConditionData*>(this)->updateQueryResult(matchesQuery());
 
   return m_active;
 }
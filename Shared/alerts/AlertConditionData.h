@@ -30,6 +30,7 @@
 
 namespace Dsa {
 
+class AlertCondition;
 class AlertSource;
 class AlertTarget;
 
@@ -58,7 +59,9 @@ public:
   void setViewed(bool viewed);
 
   bool isActive() const;
+  quint64 activationOrder() const;
 
+  AlertCondition* condition() const;
   AlertSource* source() const;
   AlertTarget* target() const;
 
@@ -66,6 +69,8 @@ public:
 
   bool cachedQueryResult() const;
   bool isQueryOutOfDate() const;
+  void invalidateQuery();
+  void updateQueryResult(bool matchesQuery);
 
   bool isConditionEnabled() const;
   void setConditionEnabled(bool isConditionEnabled);
@@ -77,9 +82,6 @@ signals:
   void activeChanged();
   void noLongerValid();
 
-private slots:
-  void handleDataChanged();
-
 private:
   void setActive(bool active);
 
@@ -91,6 +93,7 @@ private:
   bool m_enabled = true;
   bool m_viewed = false;
   bool m_active = false;
+  quint64 m_activationOrder = 0;
   bool m_queryOutOfDate = true;
   mutable bool m_cachedQueryResult = false;
 };
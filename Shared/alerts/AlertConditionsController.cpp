@@ -25,8 +25,10 @@
 #include "AlertConditionListModel.h"
 #include "AlertConstants.h"
 #include "AlertListModel.h"
+#include "AlertScheduler.h"
 #include "AttributeEqualsAlertCondition.h"
 #include "FeatureLayerAlertTarget.h"
+#include "FeatureTargetCache.h"
 #include "FixedValueAlertTarget.h"
 #include "GeoElementAlertTarget.h"
 #include "GraphicsOverlayAlertTarget.h"
@@ -52,7 +54,6 @@
 #include "LayerListModel.h"
 
 // Qt headers
-#include <QEventLoop>
 #include <QJsonArray>
 #include <QJsonObject>
 
@@ -125,12 +126,40 @@ QString AlertConditionsController::toolName() const
  * \list
  *  \li Conditions. A list of JSON objects describing alert conditions to be added to the map.
  *  \li MessageFeeds. A list of real-time feeds to be used as condition sources.
+ *  \li AlertEvaluation. A JSON object with the \c rate and \c critical_rate (ticks per second),
+ *  \c tick_budget (milliseconds), \c concurrent (whether to use a thread pool) and
+ *  \c local_frame_tolerance (meters, enabling planar distance tests) for the \l AlertScheduler.
  * \endlist
  */
 void AlertConditionsController::setProperties(const QVariantMap& properties)
 {
   const auto conditionsData = properties[AlertConstants::ALERT_CONDITIONS_PROPERTYNAME];
 
+  const auto evaluationConfig = properties[AlertConstants::ALERT_EVALUATION_PROPERTYNAME].toMap();
+  if (!evaluationConfig.isEmpty())
+  {
+    AlertScheduler* scheduler = AlertScheduler::instance();
+    bool ok = false;
+    const double rate = evaluationConfig.value(AlertConstants::EVALUATION_RATE).toDouble(&ok);
+    if (ok)
+      scheduler->setRate(rate);
+
+    const double criticalRate = evaluationConfig.value(AlertConstants::EVALUATION_CRITICAL_RATE).toDouble(&ok);
+    if (ok)
+      scheduler->setCriticalRate(criticalRate);
+
+    const int tickBudget = evaluationConfig.value(AlertConstants::EVALUATION_TICK_BUDGET).toInt(&ok);
+    if (ok)
+      scheduler->setTickBudget(tickBudget);
+
+    if (evaluationConfig.contains(AlertConstants::EVALUATION_CONCURRENT))
+      scheduler->setConcurrent(evaluationConfig.value(AlertConstants::EVALUATION_CONCURRENT).toBool());
+
+    const double localFrameTolerance = evaluationConfig.value(AlertConstants::EVALUATION_LOCAL_FRAME_TOLERANCE).toDouble(&ok);
+    if (ok)
+      scheduler->setLocalFrameTolerance(localFrameTolerance);
+  }
+
   const auto messageFeeds = properties[MessageFeedConstants::MESSAGE_FEEDS_PROPERTYNAME].toList();
   if (!messageFeeds.isEmpty())
   {
@@ -218,6 +247,7 @@ void AlertConditionsController::setActive(bool active)
       In the case where the target is a \l Esri::ArcGISRuntime::GraphicsOverlay, the  id should be the
       index of the graphic. In the case where the target is a \l Esri::ArcGISRuntime::FeatureLayer, the
       id should be the primary key value (e.g. the OID).
+      The feature is fetched asynchronously and the condition is evaluated against it once it has been found.
     \li \a targetOverlayIndex. The index of the target for the condition in the \l targetNames list. A target can be either
     a \l Esri::ArcGISRuntime::GraphicsOverlay or a \l Esri::ArcGISRuntime::FeatureLayer.
   \endlist
@@ -277,7 +307,7 @@ bool AlertConditionsController::addWithinDistanceAlert(const QString& conditionN
     }
   }
 
-  return m_conditions->addAlertCondition(condition);
+  return addCondition(condition);
 }
 
 /*!
@@ -292,6 +322,7 @@ bool AlertConditionsController::addWithinDistanceAlert(const QString& conditionN
       In the case where the target is a \l Esri::ArcGISRuntime::GraphicsOverlay, the  id should be the
       index of the graphic. In the case where the target is a \l Esri::ArcGISRuntime::FeatureLayer, the
       id should be the primary key value (e.g. the OID).
+      The feature is fetched asynchronously and the condition is evaluated against it once it has been found.
     \li \a targetOverlayIndex. The index of the target for the condition in the \l targetNames list. A target can be either
     a \l Esri::ArcGISRuntime::GraphicsOverlay or a \l Esri::ArcGISRuntime::FeatureLayer.
   \endlist
@@ -349,7 +380,7 @@ bool AlertConditionsController::addWithinAreaAlert(const QString& conditionName,
     }
   }
 
-  return m_conditions->addAlertCondition(condition);
+  return addCondition(condition);
 }
 
 /*!
@@ -372,34 +403,76 @@ bool AlertConditionsController::addAttributeEqualsAlert(const QString& condition
                                                         const QString& attributeName,
                                                         const QVariant& targetValue)
 {
-  if (levelIndex < 0 ||
-      sourceFeedName.isEmpty() ||
-      attributeName.isEmpty() ||
-      targetValue.isNull())
-  {
-    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QStringLiteral("Invalid inputs"));
-    return false;
-  }
+  return addAttributeCondition(conditionName, levelIndex, sourceFeedName, attributeName,
+                               AttributePredicate::Operator::Equals, targetValue, targetValue.toString());
+}
 
-  AlertLevel level = static_cast<AlertLevel>(levelIndex);
-  if (level > AlertLevel::Critical)
+/*!
+  \brief Adds a \l AttributeEqualsAlertCondition, which compares an attribute using a given operator,
+  to the list of conditions.
+
+  \list
+    \li \a conditionName. The name for the condition.
+    \li \a levelIndex. The \l AlertLevel for the condition.
+    \li \a sourceFeedName. The name of the source feed
+      (e.g. a \l Esri::ArcGISRuntime::GraphicsOverlay) used to create an \l AlertSource.
+    \li \a attributeName. The name of the attribute to query.
+    \li \a operatorIndex. The \l AttributePredicate::Operator used to compare the attribute.
+    \li \a operand. The value to compare the attribute with. For a range this is the minimum and
+      maximum separated by a comma (either of which can be empty). For a set this is the values
+      separated by commas.
+  \endlist
+
+  Returns \c true if the condition was succesfully added
+ */
+bool AlertConditionsController::addAttributeAlert(const QString& conditionName,
+                                                  int levelIndex,
+                                                  const QString& sourceFeedName,
+                                                  const QString& attributeName,
+                                                  int operatorIndex,
+                                                  const QString& operand)
+{
+  if (operatorIndex < static_cast<int>(AttributePredicate::Operator::Equals) ||
+      operatorIndex > static_cast<int>(AttributePredicate::Operator::StartsWith))
   {
-    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QStringLiteral("Invalid Alert Level"));
+    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QStringLiteral("Invalid attribute operator"));
     return false;
   }
 
-  AlertTarget* target = new FixedValueAlertTarget(targetValue, this);
+  const AttributePredicate::Operator op = static_cast<AttributePredicate::Operator>(operatorIndex);
+  return addAttributeCondition(conditionName, levelIndex, sourceFeedName, attributeName,
+                               op, AttributePredicate::parseOperand(op, operand), operand);
+}
 
-  GraphicsOverlay* sourceOverlay = graphicsOverlayFromName(sourceFeedName);
-  if (!sourceOverlay)
+/*!
+  \brief internal
+
+  Adds the \a condition to the list. It is removed again if it becomes invalid, for example
+  because the feature it targets no longer exists. The condition is still saved, and is added
+  again with the other stored conditions once its target can be found.
+ */
+bool AlertConditionsController::addCondition(AlertCondition* condition)
+{
+  connect(condition, &AlertCondition::noLongerValid, this, [this, condition]()
   {
-    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QString("Could not find source feed: %1").arg(sourceFeedName));
-    return false;
-  }
+    const int rowCount = m_conditions->rowCount();
+    for (int i = 0; i < rowCount; ++i)
+    {
+      if (m_conditions->conditionAt(i) != condition)
+        continue;
+
+      // the condition may be being destroyed, so the JSON it was last saved as is used rather than serializing it again
+      const QJsonObject conditionJson = m_conditionsJson.value(condition);
+      if (!conditionJson.isEmpty() && !m_storedConditions.contains(conditionJson))
+        m_storedConditions.append(conditionJson);
+
+      // for the same reason, it is only deleted once control returns to the event loop
+      m_conditions->removeAt(i);
+      condition->deleteLater();
+      return;
+    }
+  });
 
-  AttributeEqualsAlertCondition* condition = new AttributeEqualsAlertCondition(level, conditionName, attributeName, this);
-  connect(condition, &AttributeEqualsAlertCondition::newConditionData, this, &AlertConditionsController::handleNewAlertConditionData);
-  condition->init(sourceOverlay, sourceFeedName, target, targetValue.toString());
   return m_conditions->addAlertCondition(condition);
 }
 
@@ -828,6 +901,7 @@ void AlertConditionsController::onConditionsChanged()
   emit conditionsListChanged();
 
   QJsonArray allConditionsJson;
+  m_conditionsJson.clear();
   const int conditionsCount = m_conditions->rowCount();
   for(int i = 0; i < conditionsCount; ++i)
   {
@@ -840,6 +914,7 @@ void AlertConditionsController::onConditionsChanged()
       continue;
 
     allConditionsJson.append(conditionJson);
+    m_conditionsJson.insert(condition, conditionJson);
   }
 
   for (const QJsonObject& unadded : m_storedConditions)
@@ -965,7 +1040,9 @@ bool AlertConditionsController::addConditionFromJson(const QJsonObject& json)
     if (attributeName.isEmpty())
       return false;
 
-    return addAttributeEqualsAlert(conditionName, level, sourceString, attributeName, targetString );
+    const AttributePredicate::Operator op = AttributeEqualsAlertCondition::operatorFromQueryComponents(queryComponents);
+    return addAttributeCondition(conditionName, level, sourceString, attributeName,
+                                 op, AttributePredicate::parseOperand(op, targetString), targetString);
   }
   else if (isWithinArea || isWithinDistance)
   {
@@ -988,11 +1065,6 @@ bool AlertConditionsController::addConditionFromJson(const QJsonObject& json)
     if (targetOverlayIndex == -1)
       return false;
 
-    QString targetDescription;
-    AlertTarget* target = targetFromItemIdAndIndex(itemId, targetOverlayIndex, targetDescription);
-    if (!target)
-      return false;
-
     if (isWithinArea)
     {
       return addWithinAreaAlert(conditionName, level, sourceString, itemId, targetOverlayIndex );
@@ -1037,6 +1109,57 @@ void AlertConditionsController::addStoredConditions()
   onConditionsChanged();
 }
 
+/*!
+  \brief internal
+
+  Adds a \l AttributeEqualsAlertCondition comparing the attribute with \a targetValue using \a op.
+  The \a targetDescription is the target value as it is displayed and saved.
+ */
+bool AlertConditionsController::addAttributeCondition(const QString& conditionName,
+                                                      int levelIndex,
+                                                      const QString& sourceFeedName,
+                                                      const QString& attributeName,
+                                                      AttributePredicate::Operator op,
+                                                      const QVariant& targetValue,
+                                                      const QString& targetDescription)
+{
+  if (levelIndex < 0 ||
+      sourceFeedName.isEmpty() ||
+      attributeName.isEmpty() ||
+      targetValue.isNull())
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QStringLiteral("Invalid inputs"));
+    return false;
+  }
+
+  AlertLevel level = static_cast<AlertLevel>(levelIndex);
+  if (level > AlertLevel::Critical)
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QStringLiteral("Invalid Alert Level"));
+    return false;
+  }
+
+  if (!AttributePredicate::compile(op, targetValue).isValid())
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QString("Invalid value for attribute condition: %1").arg(targetDescription));
+    return false;
+  }
+
+  GraphicsOverlay* sourceOverlay = graphicsOverlayFromName(sourceFeedName);
+  if (!sourceOverlay)
+  {
+    emit toolErrorOccurred(QStringLiteral("Failed to create Condition"), QString("Could not find source feed: %1").arg(sourceFeedName));
+    return false;
+  }
+
+  AlertTarget* target = new FixedValueAlertTarget(targetValue, this);
+
+  AttributeEqualsAlertCondition* condition = new AttributeEqualsAlertCondition(level, conditionName, attributeName, op, this);
+  connect(condition, &AttributeEqualsAlertCondition::newConditionData, this, &AlertConditionsController::handleNewAlertConditionData);
+  condition->init(sourceOverlay, sourceFeedName, target, targetDescription);
+  return addCondition(condition);
+}
+
 /*!
   \brief internal
  */
@@ -1136,36 +1259,18 @@ AlertTarget* AlertConditionsController::targetFromFeatureLayer(FeatureLayer* fea
   if (!tab)
     return nullptr;
 
-  const QString primaryKey = primaryKeyFieldName(tab);
-
-  QueryParameters qp;
-  qp.setWhereClause(QString("\"%1\" = %2").arg(primaryKey, QString::number(itemId)));
-
-  QEventLoop loop;
-  tab->queryFeatures(qp);
-
-  connect(tab, &FeatureTable::errorOccurred, this, [&loop](Error)
-  {
-    loop.quit();
-  });
-
-  Feature* feature = nullptr;
-  auto connection = loop.connect(tab, &FeatureTable::queryFeaturesCompleted, this, [&loop, &feature](QUuid, FeatureQueryResult* featureQueryResult)
+  // features are fetched asynchronously, in one query for all of the targets requested together
+  QPointer<FeatureTargetCache>& cache = m_featureTargetCaches[tab];
+  if (!cache)
   {
-    loop.quit();
+    const QString primaryKey = primaryKeyFieldName(tab);
+    if (primaryKey.isEmpty())
+      return nullptr;
 
-    if (featureQueryResult)
-      feature = featureQueryResult->iterator().next();
-  });
-
-  loop.exec();
-
-  disconnect(connection);
-
-  if (!feature)
-    return nullptr;
+    cache = new FeatureTargetCache(tab, primaryKey);
+  }
 
-  return new GeoElementAlertTarget(feature);
+  return cache->target(itemId);
 }
 
 /*!
@@ -20,12 +20,16 @@
 // toolkit headers
 #include "AbstractTool.h"
 
+// dsa app headers
+#include "AttributePredicate.h"
+
 // C++ API headers
 #include "TaskWatcher.h"
 
 // Qt headers
 #include <QHash>
 #include <QJsonObject>
+#include <QPointer>
 #include <QStringListModel>
 
 class QMouseEvent;
@@ -47,6 +51,7 @@ class AlertCondition;
 class AlertConditionData;
 class AlertConditionListModel;
 class AlertTarget;
+class FeatureTargetCache;
 class LocationAlertSource;
 class LocationAlertTarget;
 
@@ -74,6 +79,7 @@ public:
   Q_INVOKABLE bool addWithinDistanceAlert(const QString& conditionName, int levelIndex, const QString& sourceFeedname, double distance, int itemId, int targetOverlayIndex);
   Q_INVOKABLE bool addWithinAreaAlert(const QString& conditionName, int levelIndex, const QString& sourceFeedname, int itemId, int targetOverlayIndex);
   Q_INVOKABLE bool addAttributeEqualsAlert(const QString& conditionName, int levelIndex, const QString& sourceFeedname, const QString& attributeName, const QVariant& targetValue);
+  Q_INVOKABLE bool addAttributeAlert(const QString& conditionName, int levelIndex, const QString& sourceFeedname, const QString& attributeName, int operatorIndex, const QString& operand);
   Q_INVOKABLE void removeConditionAt(int rowIndex);
   Q_INVOKABLE void togglePickMode();
   Q_INVOKABLE void updateConditionName(int rowIndex, const QString& conditionName);
@@ -107,7 +113,10 @@ private:
   void setSourceNames(const QStringList& sourceNames);
   QJsonObject conditionToJson(AlertCondition* condition) const;
   bool addConditionFromJson(const QJsonObject& json);
+  bool addCondition(AlertCondition* condition);
   void addStoredConditions();
+  bool addAttributeCondition(const QString& conditionName, int levelIndex, const QString& sourceFeedName, const QString& attributeName,
+                             AttributePredicate::Operator op, const QVariant& targetValue, const QString& targetDescription);
 
   AlertTarget* targetFromItemIdAndIndex(int itemId, int targetOverlayIndex, QString& targetDescription) const;
   AlertTarget* targetFromFeatureLayer(Esri::ArcGISRuntime::FeatureLayer* featureLayer, int itemId) const;
@@ -130,7 +139,9 @@ private:
   Esri::ArcGISRuntime::TaskWatcher m_identifyGraphicsWatcher;
   mutable QHash<QString,AlertTarget*> m_layerTargets;
   mutable QHash<QString,AlertTarget*> m_overlayTargets;
+  mutable QHash<Esri::ArcGISRuntime::FeatureTable*, QPointer<FeatureTargetCache>> m_featureTargetCaches;
   QList<QJsonObject> m_storedConditions;
+  QHash<AlertCondition*, QJsonObject> m_conditionsJson; // the last saved JSON of each condition in the list
   QHash<QString,QString> m_messageFeedTypesToNames;
 
   QMetaObject::Connection m_mouseClickConnection;
@@ -27,13 +27,20 @@
 namespace Dsa {
 
 const QString AlertConstants::ALERT_CONDITIONS_PROPERTYNAME = "Conditions";
+const QString AlertConstants::ALERT_EVALUATION_PROPERTYNAME = "AlertEvaluation";
 const QString AlertConstants::ATTRIBUTE_NAME = "attribute_name";
+const QString AlertConstants::ATTRIBUTE_OPERATOR = "attribute_operator";
 const QString AlertConstants::CONDITION_TYPE = "condition_type";
 const QString AlertConstants::CONDITION_NAME = "name";
 const QString AlertConstants::CONDITION_LEVEL = "level";
 const QString AlertConstants::CONDITION_SOURCE = "source";
 const QString AlertConstants::CONDITION_QUERY = "query";
 const QString AlertConstants::CONDITION_TARGET = "target";
+const QString AlertConstants::EVALUATION_RATE = "rate";
+const QString AlertConstants::EVALUATION_CRITICAL_RATE = "critical_rate";
+const QString AlertConstants::EVALUATION_TICK_BUDGET = "tick_budget";
+const QString AlertConstants::EVALUATION_CONCURRENT = "concurrent";
+const QString AlertConstants::EVALUATION_LOCAL_FRAME_TOLERANCE = "local_frame_tolerance";
 const QString AlertConstants::METERS = "meters";
 const QString AlertConstants::MY_LOCATION = "My Location";
 
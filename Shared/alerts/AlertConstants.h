@@ -25,13 +25,20 @@ namespace Dsa {
 class AlertConstants {
 public:
   static const QString ALERT_CONDITIONS_PROPERTYNAME;
+  static const QString ALERT_EVALUATION_PROPERTYNAME;
   static const QString ATTRIBUTE_NAME;
+  static const QString ATTRIBUTE_OPERATOR;
   static const QString CONDITION_TYPE;
   static const QString CONDITION_NAME;
   static const QString CONDITION_LEVEL;
   static const QString CONDITION_SOURCE;
   static const QString CONDITION_QUERY;
   static const QString CONDITION_TARGET;
+  static const QString EVALUATION_RATE;
+  static const QString EVALUATION_CRITICAL_RATE;
+  static const QString EVALUATION_TICK_BUDGET;
+  static const QString EVALUATION_CONCURRENT;
+  static const QString EVALUATION_LOCAL_FRAME_TOLERANCE;
   static const QString METERS;
   static const QString MY_LOCATION;
 
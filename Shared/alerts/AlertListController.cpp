@@ -24,6 +24,7 @@
 #include "AlertConditionData.h"
 #include "AlertListModel.h"
 #include "AlertListProxyModel.h"
+#include "AlertListSortedProxyModel.h"
 #include "AlertSource.h"
 #include "DsaUtility.h"
 #include "IdsAlertFilter.h"
@@ -61,8 +62,12 @@ namespace Dsa {
 
   It also allows individual alerts to highlighted, zoomed to and marked as viewed.
 
+  The alerts are listed by descending level and then by the time they became active, and can
+  optionally be grouped by \l AlertCondition.
+
   \sa AlertListModel
   \sa AlertListProxyModel
+  \sa AlertListSortedProxyModel
   \sa AlertConditionData
  */
 
@@ -72,6 +77,7 @@ namespace Dsa {
 AlertListController::AlertListController(QObject* parent /* = nullptr */):
   AbstractTool(parent),
   m_alertsProxyModel(new AlertListProxyModel(AlertListModel::instance(), this)),
+  m_sortedAlertsModel(new AlertListSortedProxyModel(m_alertsProxyModel, this)),
   m_statusAlertFilter(new StatusAlertFilter(this)),
   m_idsAlertFilter(new IdsAlertFilter(this)),
   m_highlighter(new PointHighlighter(this))
@@ -82,6 +88,8 @@ AlertListController::AlertListController(QObject* parent /* = nullptr */):
   // sets the initial set of filters for condition data
   m_alertsProxyModel->applyFilter(m_filters);
 
+  connect(m_sortedAlertsModel, &AlertListSortedProxyModel::groupedChanged, this, &AlertListController::groupByConditionChanged);
+
   connect(AlertListModel::instance(), &AlertListModel::dataChanged, this, &AlertListController::allAlertsCountChanged);
   connect(AlertListModel::instance(), &AlertListModel::rowsInserted, this, &AlertListController::allAlertsCountChanged);
   connect(AlertListModel::instance(), &AlertListModel::rowsRemoved, this, &AlertListController::allAlertsCountChanged);
@@ -99,11 +107,31 @@ AlertListController::~AlertListController()
 
 /*!
   \property AlertListController::alertListModel
-  \brief Returns a model containing the filtered list of active alert condition data.
+  \brief Returns a model containing the filtered and sorted list of active alert condition data.
  */
 QAbstractItemModel* AlertListController::alertListModel() const
 {
-  return m_alertsProxyModel;
+  return m_sortedAlertsModel;
+}
+
+/*!
+  \property AlertListController::groupByCondition
+  \brief Returns whether the alert list model has a single row for each \l AlertCondition.
+
+  Each grouped row represents the most severe, most recent alert of the condition. Marking a
+  grouped row as viewed, or dismissing it, applies to every alert of the condition in the list.
+ */
+bool AlertListController::isGroupByCondition() const
+{
+  return m_sortedAlertsModel->isGrouped();
+}
+
+/*!
+  \brief Sets whether the alert list model has a single row for each \l AlertCondition to \a groupByCondition.
+ */
+void AlertListController::setGroupByCondition(bool groupByCondition)
+{
+  m_sortedAlertsModel->setGrouped(groupByCondition);
 }
 
 /*!
@@ -155,8 +183,7 @@ void AlertListController::highlight(int rowIndex, bool showHighlight)
 {
   if (showHighlight)
   {
-    QModelIndex sourceIndex = m_alertsProxyModel->mapToSource(m_alertsProxyModel->index(rowIndex, 0));
-    AlertConditionData* conditionData = AlertListModel::instance()->alertAt(sourceIndex.row());
+    AlertConditionData* conditionData = alertAt(rowIndex);
 
     if (!conditionData)
       return;
@@ -166,9 +193,11 @@ void AlertListController::highlight(int rowIndex, bool showHighlight)
 
     m_highlightConnections.clear();
 
+    // condition data is deleted when it stops matching its condition, so the highlight is stopped
+    // and no longer tracks the data
     m_highlightConnections.append(connect(conditionData, &AlertConditionData::noLongerValid, this, [this]()
     {
-      m_highlighter->stopHighlight();
+      highlight(-1, false);
     }));
 
     m_highlightConnections.append(connect(conditionData->source(), &AlertSource::dataChanged, this, [this, conditionData]()
@@ -218,8 +247,7 @@ void AlertListController::highlight(int rowIndex, bool showHighlight)
  */
 void AlertListController::zoomTo(int rowIndex)
 {
-  QModelIndex sourceIndex = m_alertsProxyModel->mapToSource(m_alertsProxyModel->index(rowIndex, 0));
-  AlertConditionData* alert = AlertListModel::instance()->alertAt(sourceIndex.row());
+  AlertConditionData* alert = alertAt(rowIndex);
   if (!alert)
     return;
 
@@ -250,30 +278,44 @@ void AlertListController::zoomTo(int rowIndex)
 
 /*!
   \brief Sets the viewed state of the active alert at index \a rowIndex in the filtered model to \c true.
+
+  When the alerts are grouped by condition, every alert of the group is marked as viewed.
  */
 void AlertListController::setViewed(int rowIndex)
 {
-  QModelIndex sourceIndex = m_alertsProxyModel->mapToSource(m_alertsProxyModel->index(rowIndex, 0));
+  const QList<AlertConditionData*> alerts = alertsAt(rowIndex);
+  if (alerts.isEmpty())
+    return;
+
   AlertListModel* model = AlertListModel::instance();
   if (!model)
     return;
 
-  model->setData(sourceIndex, QVariant::fromValue(true), AlertListModel::AlertListRoles::Viewed);
+  for (AlertConditionData* alert : alerts)
+  {
+    if (alert)
+      model->setData(model->index(model->rowOf(alert), 0), QVariant::fromValue(true), AlertListModel::AlertListRoles::Viewed);
+  }
 }
 
 /*!
   \brief Dismiss the active alert at index \a rowIndex in the filtered model.
 
-  This will add the ID of the alert condition data to the current \l IdsAlertFilter.
+  This will add the ID of the alert condition data to the current \l IdsAlertFilter. When the
+  alerts are grouped by condition, every alert of the group is dismissed.
  */
 void AlertListController::dismiss(int rowIndex)
 {
-  QModelIndex sourceIndex = m_alertsProxyModel->mapToSource(m_alertsProxyModel->index(rowIndex, 0));
-  AlertConditionData* alert = AlertListModel::instance()->alertAt(sourceIndex.row());
-  if (!alert)
+  const QList<AlertConditionData*> alerts = alertsAt(rowIndex);
+  if (alerts.isEmpty())
     return;
 
-  m_idsAlertFilter->addId(alert->id());
+  for (AlertConditionData* alert : alerts)
+  {
+    if (alert)
+      m_idsAlertFilter->addId(alert->id());
+  }
+
   m_alertsProxyModel->applyFilter(m_filters);
 }
 
@@ -326,6 +368,27 @@ void AlertListController::flashAll(bool highlight)
   }
 }
 
+/*!
+  \internal
+
+  Returns the condition data at \a rowIndex in the sorted model.
+ */
+AlertConditionData* AlertListController::alertAt(int rowIndex) const
+{
+  return m_sortedAlertsModel->alertAt(rowIndex);
+}
+
+/*!
+  \internal
+
+  Returns the alerts represented by the row at \a rowIndex: all of the alerts of its group when
+  they are grouped by condition.
+ */
+QList<AlertConditionData*> AlertListController::alertsAt(int rowIndex) const
+{
+  return m_sortedAlertsModel->alertsAt(rowIndex);
+}
+
 } // Dsa
 
 // Signal Documentation
@@ -339,6 +402,11 @@ void AlertListController::flashAll(bool highlight)
   \brief Signal emitted when the alert count changes.
  */
 
+/*!
+  \fn void AlertListController::groupByConditionChanged();
+  \brief Signal emitted when the grouping of the alert list model changes.
+ */
+
 /*!
   \fn void AlertListController::highlightStopped();
   \brief Signal emitted highlighting has stopped.
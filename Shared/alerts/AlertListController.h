@@ -34,8 +34,10 @@ namespace Dsa {
 
 class PointHighlighter;
 
+class AlertConditionData;
 class AlertFilter;
 class AlertListProxyModel;
+class AlertListSortedProxyModel;
 class IdsAlertFilter;
 class StatusAlertFilter;
 
@@ -45,6 +47,7 @@ class AlertListController : public AbstractTool
 
   Q_PROPERTY(QAbstractItemModel* alertListModel READ alertListModel NOTIFY alertListModelChanged)
   Q_PROPERTY(int allAlertsCount READ allAlertsCount NOTIFY allAlertsCountChanged)
+  Q_PROPERTY(bool groupByCondition READ isGroupByCondition WRITE setGroupByCondition NOTIFY groupByConditionChanged)
 
 public:
   explicit AlertListController(QObject* parent = nullptr);
@@ -53,6 +56,9 @@ public:
   QAbstractItemModel* alertListModel() const;
   int allAlertsCount() const;
 
+  bool isGroupByCondition() const;
+  void setGroupByCondition(bool groupByCondition);
+
   // AbstractTool interface
   QString toolName() const override;
 
@@ -68,10 +74,15 @@ public:
 signals:
   void alertListModelChanged();
   void allAlertsCountChanged();
+  void groupByConditionChanged();
   void highlightStopped();
 
 private:
+  AlertConditionData* alertAt(int rowIndex) const;
+  QList<AlertConditionData*> alertsAt(int rowIndex) const;
+
   AlertListProxyModel* m_alertsProxyModel = nullptr;
+  AlertListSortedProxyModel* m_sortedAlertsModel = nullptr;
   StatusAlertFilter* m_statusAlertFilter = nullptr;
   IdsAlertFilter* m_idsAlertFilter = nullptr;
   QList<AlertFilter*> m_filters;
@@ -20,10 +20,16 @@
 #include "AlertListModel.h"
 
 // dsa app headers
+#include "AlertCondition.h"
 #include "AlertConditionData.h"
 
 // Qt headers
+#include <QTimer>
 #include <QUuid>
+#include <QVector>
+
+// STL headers
+#include <algorithm>
 
 using namespace Esri::ArcGISRuntime;
 
@@ -58,6 +64,15 @@ namespace Dsa {
         \li viewed
         \li bool
         \li Whether the alert condition has been viewed.
+    \row
+        \li conditionName
+        \li QString
+        \li The name of the \l AlertCondition which created the alert.
+    \row
+        \li groupCount
+        \li int
+        \li The number of alerts represented by the row. This is always 1, unless the rows
+          are grouped by \l AlertListSortedProxyModel.
   \endtable
  */
 
@@ -82,6 +97,8 @@ AlertListModel::AlertListModel(QObject* parent):
   m_roles[AlertListRoles::Name] = "name";
   m_roles[AlertListRoles::Level] = "level";
   m_roles[AlertListRoles::Viewed] = "viewed";
+  m_roles[AlertListRoles::ConditionName] = "conditionName";
+  m_roles[AlertListRoles::GroupCount] = "groupCount";
 }
 
 /*!
@@ -102,34 +119,17 @@ bool AlertListModel::addAlertConditionData(AlertConditionData* newConditionData)
   if (!newConditionData)
     return false;
 
-  if (!newConditionData->id().isNull())
+  if (m_rows.contains(newConditionData))
     return false;
 
-  const int size = m_alerts.size();
-  const int insertIdx = size == 0 ? 0 : size;
-  const QUuid id = QUuid::createUuid();
-  newConditionData->setId(id);
+  // condition data which is re-created when a source matches again keeps its previous ID
+  const int insertIdx = m_alerts.size();
+  if (newConditionData->id().isNull())
+    newConditionData->setId(QUuid::createUuid());
 
   auto handleDataChanged = [this, newConditionData]()
   {
-    if (newConditionData->id().isNull())
-      return;
-
-    auto it = m_alerts.cbegin();
-    auto itEnd = m_alerts.cend();
-    int currRow = 0;
-    for (; it != itEnd; ++it, ++currRow)
-    {
-      AlertConditionData* testAlert = *it;
-      if (!testAlert)
-        continue;
-
-      if (testAlert->id() == newConditionData->id())
-      {
-        const QModelIndex changedIndex = index(currRow, 0);
-        emit dataChanged(changedIndex, changedIndex);
-      }
-    }
+    handleAlertChanged(newConditionData);
   };
 
   connect(newConditionData, &AlertConditionData::viewedChanged, this, handleDataChanged);
@@ -142,6 +142,7 @@ bool AlertListModel::addAlertConditionData(AlertConditionData* newConditionData)
 
   beginInsertRows(QModelIndex(), insertIdx, insertIdx);
   m_alerts.append(newConditionData);
+  m_rows.insert(newConditionData, insertIdx);
   endInsertRows();
 
   return true;
@@ -155,23 +156,37 @@ void AlertListModel::removeAlert(AlertConditionData* conditionData)
   if (!conditionData)
     return;
 
-  if (conditionData->id().isNull())
+  const int row = rowOf(conditionData);
+  if (row == -1)
     return;
 
-  const QUuid theId = conditionData->id();
+  removeAt(row);
+}
 
-  for (int i = 0; i < m_alerts.size(); ++i)
-  {
-    AlertConditionData* testAlert = m_alerts.at(i);
-    if (!testAlert)
-      continue;
+/*!
+  \brief Returns the row of \a alert in the model, or \c -1 if it is not in the model.
 
-    if (testAlert->id() != theId)
-      continue;
+  Rows are stored in a hash, so this does not scan the model. After a removal, the rows which
+  followed it are only updated when they are next needed.
+ */
+int AlertListModel::rowOf(AlertConditionData* alert) const
+{
+  auto findIt = m_rows.constFind(alert);
+  if (findIt == m_rows.cend())
+    return -1;
 
-    removeAt(i);
-    break;
-  }
+  const int row = findIt.value();
+  if (row < m_firstStaleRow)
+    return row;
+
+  // update the rows which have moved since the first removal
+  const int count = m_alerts.size();
+  for (int i = m_firstStaleRow; i < count; ++i)
+    m_rows[m_alerts.at(i)] = i;
+
+  m_firstStaleRow = count;
+
+  return m_rows.value(alert, -1);
 }
 
 /*!
@@ -194,9 +209,80 @@ void AlertListModel::removeAt(int rowIndex)
 
   beginRemoveRows(QModelIndex(), rowIndex, rowIndex);
   m_alerts.removeAt(rowIndex);
+  m_rows.remove(alert);
+  m_changedAlerts.remove(alert);
+  m_firstStaleRow = std::min(m_firstStaleRow, rowIndex);
   endRemoveRows();
 }
 
+/*!
+  \internal
+
+  Records that \a alert has changed. The changes made in one turn of the event loop are reported
+  together by \l emitPendingChanges.
+ */
+void AlertListModel::handleAlertChanged(AlertConditionData* alert)
+{
+  if (alert->id().isNull())
+    return;
+
+  m_changedAlerts.insert(alert);
+
+  if (m_changesScheduled)
+    return;
+
+  m_changesScheduled = true;
+  QTimer::singleShot(0, this, [this]()
+  {
+    emitPendingChanges();
+  });
+}
+
+/*!
+  \internal
+
+  Emits \l dataChanged for the alerts which have changed, with one signal for each contiguous
+  range of changed rows.
+ */
+void AlertListModel::emitPendingChanges()
+{
+  m_changesScheduled = false;
+
+  QVector<int> changedRows;
+  changedRows.reserve(m_changedAlerts.size());
+  for (AlertConditionData* alert : qAsConst(m_changedAlerts))
+  {
+    const int row = rowOf(alert);
+    if (row != -1)
+      changedRows.append(row);
+  }
+
+  m_changedAlerts.clear();
+
+  if (changedRows.isEmpty())
+    return;
+
+  std::sort(changedRows.begin(), changedRows.end());
+
+  int rangeStart = changedRows.first();
+  int rangeEnd = rangeStart;
+  for (int i = 1; i < changedRows.size(); ++i)
+  {
+    const int row = changedRows.at(i);
+    if (row == rangeEnd + 1)
+    {
+      rangeEnd = row;
+      continue;
+    }
+
+    emit dataChanged(index(rangeStart, 0), index(rangeEnd, 0));
+    rangeStart = row;
+    rangeEnd = row;
+  }
+
+  emit dataChanged(index(rangeStart, 0), index(rangeEnd, 0));
+}
+
 
 /*!
   \brief Returns the number of condition data objects in the model.
@@ -234,6 +320,13 @@ QVariant AlertListModel::data(const QModelIndex& index, int role) const
   {
     return alert->viewed();
   }
+  case AlertListRoles::ConditionName:
+  {
+    AlertCondition* condition = alert->condition();
+    return condition ? condition->name() : QString();
+  }
+  case AlertListRoles::GroupCount:
+    return 1;
   default:
     break;
   }
@@ -266,6 +359,10 @@ bool AlertListModel::setData(const QModelIndex& index, const QVariant& value, in
     break;
   case AlertListRoles::Name:
     break;
+  case AlertListRoles::ConditionName:
+    break;
+  case AlertListRoles::GroupCount:
+    break;
   case AlertListRoles::Viewed:
   {
     const bool newViewed = value.toBool();
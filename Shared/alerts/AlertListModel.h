@@ -21,6 +21,7 @@
 #include <QAbstractListModel>
 #include <QHash>
 #include <QList>
+#include <QSet>
 
 namespace Dsa {
 
@@ -37,7 +38,9 @@ public:
     AlertId = Qt::UserRole + 1,
     Name = Qt::UserRole + 2,
     Level = Qt::UserRole + 3,
-    Viewed = Qt::UserRole + 4
+    Viewed = Qt::UserRole + 4,
+    ConditionName = Qt::UserRole + 5,
+    GroupCount = Qt::UserRole + 6
   };
 
   static AlertListModel* instance();
@@ -48,6 +51,7 @@ public:
   void removeAlert(AlertConditionData* alert);
 
   AlertConditionData* alertAt(int rowIndex) const;
+  int rowOf(AlertConditionData* alert) const;
 
   void removeAt(int rowIndex);
 
@@ -62,8 +66,15 @@ protected:
 private:
   AlertListModel(QObject* parent = nullptr);
 
+  void handleAlertChanged(AlertConditionData* alert);
+  void emitPendingChanges();
+
   QHash<int, QByteArray>  m_roles;
   QList<AlertConditionData*>   m_alerts;
+  mutable QHash<AlertConditionData*, int> m_rows; // the row of each alert. Rows from m_firstStaleRow may be out of date
+  mutable int m_firstStaleRow = 0;
+  QSet<AlertConditionData*> m_changedAlerts;
+  bool m_changesScheduled = false;
 };
 
 } // Dsa
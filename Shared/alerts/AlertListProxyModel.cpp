@@ -24,60 +24,56 @@
 #include "AlertFilter.h"
 #include "AlertListModel.h"
 
+// STL headers
+#include <algorithm>
+
 namespace Dsa {
 
 /*!
   \class Dsa::AlertListProxyModel
   \inmodule Dsa
-  \inherits QSortFilterProxyModel
+  \inherits QAbstractProxyModel
   \brief A proxy model responsible for filtering the list of \l AlertConditionData
   to show only those which are active and statisfy the current set of \l AlertFilter tests.
+
+  The proxy keeps an ordered list of the source rows which pass the filters. Changes to the
+  source model only update the rows which are affected, with a precise insertion or removal in
+  the proxy, rather than re-running the filters for every row.
   */
 
 /*!
   \brief Constructor for a new proxy model taking a \a sourceModel and an optional \a parent.
  */
 AlertListProxyModel::AlertListProxyModel(AlertListModel* sourceModel, QObject* parent):
-  QSortFilterProxyModel(parent),
+  QAbstractProxyModel(parent),
   m_sourceModel(sourceModel)
 {
   setSourceModel(m_sourceModel);
 
-  // handle changes to a given condition data in the underlying AlertListModel
-  connect(m_sourceModel, &AlertListModel::dataChanged, this, [this](const QModelIndex& topLeft)
-  {
-    // check whether the changed condition data is currently included in the filtered model
-    const bool inModel = m_rowsInModel.value(topLeft.row(), false);
+  // handle changes to condition data in the underlying AlertListModel
+  connect(m_sourceModel, &AlertListModel::dataChanged, this, &AlertListProxyModel::handleSourceDataChanged);
 
-    // check whether the changed condition should now be included
-    const bool shouldBeInModel = passesAllQueries(topLeft.row());
-
-    // if the condition data has changed state, cache the new state and re-run the filter
-    if (inModel != shouldBeInModel)
-    {
-      m_rowsInModel.insert(topLeft.row(), shouldBeInModel);
-      invalidate();
-    }
+  // handle the addition of new condition data in the underlying AlertListModel
+  connect(m_sourceModel, &AlertListModel::rowsInserted, this, [this](const QModelIndex&, int first, int last)
+  {
+    handleSourceRowsInserted(first, last);
   });
 
-  // handle the addition of a new condition data in the underlying AlertListModel
-  connect(m_sourceModel, &AlertListModel::rowsInserted, this, [this](const QModelIndex&, int first, int)
+  // handle condition data being removed from the underlying AlertListModel
+  connect(m_sourceModel, &AlertListModel::rowsAboutToBeRemoved, this, [this](const QModelIndex&, int first, int last)
   {
-    // only clear the cache if this is an insert rather than an append
-    if (m_rowsInModel.contains(first))
-      m_rowsInModel.clear();
-
-    // re-run the filter
-    invalidate();
+    handleSourceRowsAboutToBeRemoved(first, last);
   });
 
-  // handle condition data being removed from the underlying AlertListModel
-  connect(m_sourceModel, &AlertListModel::rowsRemoved, this, [this]()
+  connect(m_sourceModel, &AlertListModel::rowsRemoved, this, [this](const QModelIndex&, int first, int last)
   {
-    m_rowsInModel.clear();
-    invalidate();
+    handleSourceRowsRemoved(first, last);
   });
 
+  connect(m_sourceModel, &AlertListModel::modelReset, this, &AlertListProxyModel::rebuild);
+  connect(m_sourceModel, &AlertListModel::layoutChanged, this, &AlertListProxyModel::rebuild);
+
+  rebuild();
 }
 
 /*!
@@ -90,34 +86,107 @@ AlertListProxyModel::~AlertListProxyModel()
 
 /*!
   \brief Applies a new set of \a filters to the condition data in the underlying \l AlertListModel.
+
+  Only the rows whose filter state changes are inserted or removed.
  */
 void AlertListProxyModel::applyFilter(const QList<AlertFilter*>& filters)
 {
   m_filters = filters;
-  m_rowsInModel.clear();
-  invalidate();
+
+  const int count = m_sourceModel->rowCount();
+  for (int sourceRow = 0; sourceRow < count; ++sourceRow)
+    updateRow(sourceRow, filterAcceptsRow(sourceRow));
 }
 
+/*!
+  \brief Returns the condition data at \a row in this model, or \c nullptr if \a row is out of range.
+ */
+AlertConditionData* AlertListProxyModel::alertAt(int row) const
+{
+  if (row < 0 || row >= m_acceptedRows.size())
+    return nullptr;
+
+  return m_sourceModel->alertAt(m_acceptedRows.at(row));
+}
 
 /*!
-  \brief Returns \c true if the condition data in the row indicated by \a sourceRow
-  should be included in the model; otherwise returns \c false.
+  \brief Returns the row of \a alert in this model, or \c -1 if it is filtered out.
+ */
+int AlertListProxyModel::rowOf(AlertConditionData* alert) const
+{
+  const int sourceRow = m_sourceModel->rowOf(alert);
+  if (sourceRow == -1)
+    return -1;
+
+  return proxyRowFor(sourceRow);
+}
+
+/*!
+  \brief Returns the index in the source model for \a proxyIndex.
+ */
+QModelIndex AlertListProxyModel::mapToSource(const QModelIndex& proxyIndex) const
+{
+  if (!proxyIndex.isValid() || proxyIndex.row() < 0 || proxyIndex.row() >= m_acceptedRows.size())
+    return QModelIndex();
+
+  return m_sourceModel->index(m_acceptedRows.at(proxyIndex.row()), proxyIndex.column());
+}
+
+/*!
+  \brief Returns the index in this model for \a sourceIndex, or an invalid index if it is filtered out.
+ */
+QModelIndex AlertListProxyModel::mapFromSource(const QModelIndex& sourceIndex) const
+{
+  if (!sourceIndex.isValid())
+    return QModelIndex();
+
+  const int proxyRow = proxyRowFor(sourceIndex.row());
+  if (proxyRow == -1)
+    return QModelIndex();
+
+  return index(proxyRow, sourceIndex.column());
+}
+
+/*!
+  \brief Returns the index for \a row and \a column. The model is a flat list, so \a parent must be invalid.
  */
-bool AlertListProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex&) const
+QModelIndex AlertListProxyModel::index(int row, int column, const QModelIndex& parent) const
 {
-  // if required, update the cache to record the filter state for the condition data
-  if (!m_rowsInModel.contains(sourceRow))
-    m_rowsInModel.insert(sourceRow, passesAllQueries(sourceRow));
+  if (parent.isValid() || row < 0 || row >= m_acceptedRows.size() || column != 0)
+    return QModelIndex();
 
-  return m_rowsInModel.value(sourceRow);
+  return createIndex(row, column);
 }
 
 /*!
-  \brief Internal.
+  \brief Returns an invalid index: the model is a flat list.
+ */
+QModelIndex AlertListProxyModel::parent(const QModelIndex&) const
+{
+  return QModelIndex();
+}
 
-  Apply all filters to the condition data at \a row
+/*!
+  \brief Returns the number of condition data objects which pass the filters.
+ */
+int AlertListProxyModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : m_acceptedRows.size();
+}
+
+/*!
+  \brief Returns the number of columns, which is always 1.
  */
-bool AlertListProxyModel::passesAllQueries(int sourceRow) const
+int AlertListProxyModel::columnCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : 1;
+}
+
+/*!
+  \brief Returns \c true if the condition data in the row indicated by \a sourceRow
+  should be included in the model; otherwise returns \c false.
+ */
+bool AlertListProxyModel::filterAcceptsRow(int sourceRow) const
 {
   // if the condition data is invalid, stop
   AlertConditionData* conditionData = m_sourceModel->alertAt(sourceRow);
@@ -143,8 +212,173 @@ bool AlertListProxyModel::passesAllQueries(int sourceRow) const
   }
 
   // if the condition data passes all filters, it should be in the filtered model
-  // if it currently satisfies its underlying condition
-  return conditionData->matchesQuery();
+  // if it currently satisfies its underlying condition. The cached result is used so that the
+  // query is not run here: if it is out of date, the data will report a change once it has been evaluated
+  return conditionData->cachedQueryResult();
+}
+
+/*!
+  \internal
+
+  Updates the filter state of each of the rows from \a topLeft to \a bottomRight, and reports
+  changes to those which remain in the model.
+ */
+void AlertListProxyModel::handleSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+  int changedStart = -1;
+  int changedEnd = -1;
+  auto emitChanged = [this, &changedStart, &changedEnd]()
+  {
+    if (changedStart != -1)
+      emit dataChanged(index(changedStart, 0), index(changedEnd, 0));
+
+    changedStart = -1;
+    changedEnd = -1;
+  };
+
+  for (int sourceRow = topLeft.row(); sourceRow <= bottomRight.row(); ++sourceRow)
+  {
+    const int proxyRow = proxyRowFor(sourceRow);
+    const bool accepted = filterAcceptsRow(sourceRow);
+    if ((proxyRow != -1) != accepted)
+    {
+      emitChanged();
+      updateRow(sourceRow, accepted);
+      continue;
+    }
+
+    if (proxyRow == -1)
+      continue;
+
+    // group the rows which are still in the model into contiguous ranges
+    if (changedStart != -1 && proxyRow == changedEnd + 1)
+    {
+      changedEnd = proxyRow;
+      continue;
+    }
+
+    emitChanged();
+    changedStart = proxyRow;
+    changedEnd = proxyRow;
+  }
+
+  emitChanged();
+}
+
+/*!
+  \internal
+
+  Shifts the rows following the insertion of source rows \a first to \a last, then adds any of
+  the new rows which pass the filters.
+ */
+void AlertListProxyModel::handleSourceRowsInserted(int first, int last)
+{
+  const int count = last - first + 1;
+  for (int i = lowerBound(first); i < m_acceptedRows.size(); ++i)
+    m_acceptedRows[i] += count;
+
+  for (int sourceRow = first; sourceRow <= last; ++sourceRow)
+  {
+    if (filterAcceptsRow(sourceRow))
+      updateRow(sourceRow, true);
+  }
+}
+
+/*!
+  \internal
+
+  Removes the proxy rows for source rows \a first to \a last, which are contiguous in the proxy.
+ */
+void AlertListProxyModel::handleSourceRowsAboutToBeRemoved(int first, int last)
+{
+  const int proxyFirst = lowerBound(first);
+  const int proxyEnd = lowerBound(last + 1);
+  if (proxyFirst == proxyEnd)
+    return;
+
+  beginRemoveRows(QModelIndex(), proxyFirst, proxyEnd - 1);
+  m_acceptedRows.remove(proxyFirst, proxyEnd - proxyFirst);
+  endRemoveRows();
+}
+
+/*!
+  \internal
+
+  Shifts the rows following the removal of source rows \a first to \a last.
+ */
+void AlertListProxyModel::handleSourceRowsRemoved(int first, int last)
+{
+  const int count = last - first + 1;
+  for (int i = lowerBound(first); i < m_acceptedRows.size(); ++i)
+    m_acceptedRows[i] -= count;
+}
+
+/*!
+  \internal
+
+  Re-runs the filters for every row in the source model.
+ */
+void AlertListProxyModel::rebuild()
+{
+  beginResetModel();
+  m_acceptedRows.clear();
+  const int count = m_sourceModel->rowCount();
+  for (int sourceRow = 0; sourceRow < count; ++sourceRow)
+  {
+    if (filterAcceptsRow(sourceRow))
+      m_acceptedRows.append(sourceRow);
+  }
+  endResetModel();
+}
+
+/*!
+  \internal
+
+  Inserts or removes the proxy row for \a sourceRow so that it is in the model if it is \a accepted.
+ */
+void AlertListProxyModel::updateRow(int sourceRow, bool accepted)
+{
+  const int proxyRow = lowerBound(sourceRow);
+  const bool inModel = proxyRow < m_acceptedRows.size() && m_acceptedRows.at(proxyRow) == sourceRow;
+  if (inModel == accepted)
+    return;
+
+  if (accepted)
+  {
+    beginInsertRows(QModelIndex(), proxyRow, proxyRow);
+    m_acceptedRows.insert(proxyRow, sourceRow);
+    endInsertRows();
+  }
+  else
+  {
+    beginRemoveRows(QModelIndex(), proxyRow, proxyRow);
+    m_acceptedRows.remove(proxyRow);
+    endRemoveRows();
+  }
+}
+
+/*!
+  \internal
+
+  Returns the proxy row for \a sourceRow, or \c -1 if it is not in the model.
+ */
+int AlertListProxyModel::proxyRowFor(int sourceRow) const
+{
+  const int proxyRow = lowerBound(sourceRow);
+  if (proxyRow < m_acceptedRows.size() && m_acceptedRows.at(proxyRow) == sourceRow)
+    return proxyRow;
+
+  return -1;
+}
+
+/*!
+  \internal
+
+  Returns the position of the first accepted row which is not before \a sourceRow.
+ */
+int AlertListProxyModel::lowerBound(int sourceRow) const
+{
+  return static_cast<int>(std::lower_bound(m_acceptedRows.cbegin(), m_acceptedRows.cend(), sourceRow) - m_acceptedRows.cbegin());
 }
 
 } // Dsa
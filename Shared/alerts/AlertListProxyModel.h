@@ -18,16 +18,17 @@
 #define ALERTLISTPROXYMODEL_H
 
 // Qt headers
-#include <QHash>
+#include <QAbstractProxyModel>
 #include <QList>
-#include <QSortFilterProxyModel>
+#include <QVector>
 
 namespace Dsa {
 
+class AlertConditionData;
 class AlertFilter;
 class AlertListModel;
 
-class AlertListProxyModel : public QSortFilterProxyModel
+class AlertListProxyModel : public QAbstractProxyModel
 {
   Q_OBJECT
 
@@ -38,16 +39,35 @@ public:
 
   void applyFilter(const QList<AlertFilter*>& filters);
 
-  // QSortFilterProxyModel interface
+  AlertConditionData* alertAt(int row) const;
+  int rowOf(AlertConditionData* alert) const;
+
+  // QAbstractProxyModel interface
+  QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+  QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+
+  // QAbstractItemModel interface
+  QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+  QModelIndex parent(const QModelIndex& child) const override;
+  int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+
 protected:
-  bool filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const override;
+  bool filterAcceptsRow(int sourceRow) const;
 
 private:
-  bool passesAllQueries(int sourceRow) const;
+  void handleSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+  void handleSourceRowsInserted(int first, int last);
+  void handleSourceRowsAboutToBeRemoved(int first, int last);
+  void handleSourceRowsRemoved(int first, int last);
+  void rebuild();
+  void updateRow(int sourceRow, bool accepted);
+  int proxyRowFor(int sourceRow) const;
+  int lowerBound(int sourceRow) const;
 
   AlertListModel* m_sourceModel;
   QList<AlertFilter*> m_filters;
-  mutable QHash<int, bool> m_rowsInModel;
+  QVector<int> m_acceptedRows; // the source rows which pass the filters, in order
 };
 
 } // Dsa
@@ -0,0 +1,580 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "AlertListSortedProxyModel.h"
+
+// dsa app headers
+#include "AlertCondition.h"
+#include "AlertConditionData.h"
+#include "AlertListModel.h"
+#include "AlertListProxyModel.h"
+
+namespace Dsa {
+
+/*!
+  \class Dsa::AlertListSortedProxyModel
+  \inmodule Dsa
+  \inherits QAbstractProxyModel
+  \brief A proxy model which orders the filtered \l AlertConditionData from an
+  \l AlertListProxyModel by descending \l AlertLevel and then by the time they became active,
+  most recent first.
+
+  The order is kept in an \l OrderStatisticsTree, so that inserting, removing or repositioning
+  an alert only affects a single row, which is reported with a precise insertion, removal or move.
+
+  The model can optionally be grouped, in which case there is one row for each \l AlertCondition.
+  Each group row represents the first alert of the condition in the order above and reports the
+  number of alerts in the group through the \c groupCount role.
+ */
+
+/*!
+  \brief Constructor for a new proxy model taking a \a sourceModel and an optional \a parent.
+ */
+AlertListSortedProxyModel::AlertListSortedProxyModel(AlertListProxyModel* sourceModel, QObject* parent):
+  QAbstractProxyModel(parent),
+  m_sourceModel(sourceModel)
+{
+  setSourceModel(m_sourceModel);
+
+  connect(m_sourceModel, &AlertListProxyModel::dataChanged, this, &AlertListSortedProxyModel::handleSourceDataChanged);
+
+  connect(m_sourceModel, &AlertListProxyModel::rowsInserted, this, [this](const QModelIndex&, int first, int last)
+  {
+    handleSourceRowsInserted(first, last);
+  });
+
+  connect(m_sourceModel, &AlertListProxyModel::rowsAboutToBeRemoved, this, [this](const QModelIndex&, int first, int last)
+  {
+    handleSourceRowsAboutToBeRemoved(first, last);
+  });
+
+  connect(m_sourceModel, &AlertListProxyModel::modelReset, this, &AlertListSortedProxyModel::rebuild);
+  connect(m_sourceModel, &AlertListProxyModel::layoutChanged, this, &AlertListSortedProxyModel::rebuild);
+
+  rebuild();
+}
+
+/*!
+  \brief Destructor.
+ */
+AlertListSortedProxyModel::~AlertListSortedProxyModel()
+{
+}
+
+/*!
+  \brief Returns whether the rows are grouped by \l AlertCondition.
+ */
+bool AlertListSortedProxyModel::isGrouped() const
+{
+  return m_grouped;
+}
+
+/*!
+  \brief Sets whether the rows are grouped by \l AlertCondition to \a grouped.
+
+  \sa groupedChanged
+ */
+void AlertListSortedProxyModel::setGrouped(bool grouped)
+{
+  if (grouped == m_grouped)
+    return;
+
+  m_grouped = grouped;
+  rebuild();
+  emit groupedChanged();
+}
+
+/*!
+  \brief Returns the condition data represented by \a row, or \c nullptr if \a row is out of range.
+
+  When the model is grouped, this is the first alert of the group.
+ */
+AlertConditionData* AlertListSortedProxyModel::alertAt(int row) const
+{
+  if (row < 0 || row >= m_rows.size())
+    return nullptr;
+
+  return m_rows.at(row).alert;
+}
+
+/*!
+  \brief Returns the alerts represented by \a row.
+
+  When the model is grouped, these are all of the alerts of the group, in order. Otherwise it
+  is just the alert at \a row.
+ */
+QList<AlertConditionData*> AlertListSortedProxyModel::alertsAt(int row) const
+{
+  QList<AlertConditionData*> alerts;
+  if (row < 0 || row >= m_rows.size())
+    return alerts;
+
+  const SortKey& key = m_rows.at(row);
+  if (!m_grouped)
+  {
+    alerts.append(key.alert);
+    return alerts;
+  }
+
+  auto findIt = m_groups.constFind(key.condition);
+  if (findIt == m_groups.constEnd())
+  {
+    alerts.append(key.alert);
+    return alerts;
+  }
+
+  const SortedAlerts& group = findIt.value();
+  const int count = group.size();
+  alerts.reserve(count);
+  for (int i = 0; i < count; ++i)
+    alerts.append(group.at(i).alert);
+
+  return alerts;
+}
+
+/*!
+  \brief Returns the index in the source model for \a proxyIndex.
+ */
+QModelIndex AlertListSortedProxyModel::mapToSource(const QModelIndex& proxyIndex) const
+{
+  if (!proxyIndex.isValid())
+    return QModelIndex();
+
+  AlertConditionData* alert = alertAt(proxyIndex.row());
+  if (!alert)
+    return QModelIndex();
+
+  return m_sourceModel->index(m_sourceModel->rowOf(alert), proxyIndex.column());
+}
+
+/*!
+  \brief Returns the index in this model for \a sourceIndex.
+
+  When the model is grouped, this is the index of the row for the group of the alert.
+ */
+QModelIndex AlertListSortedProxyModel::mapFromSource(const QModelIndex& sourceIndex) const
+{
+  if (!sourceIndex.isValid())
+    return QModelIndex();
+
+  auto findIt = m_keys.constFind(m_sourceModel->alertAt(sourceIndex.row()));
+  if (findIt == m_keys.cend())
+    return QModelIndex();
+
+  SortKey key = findIt.value();
+  if (m_grouped)
+  {
+    auto groupIt = m_groups.constFind(key.condition);
+    if (groupIt == m_groups.cend() || groupIt.value().isEmpty())
+      return QModelIndex();
+
+    key = groupIt.value().at(0);
+  }
+
+  const int row = m_rows.rankOf(key);
+  if (row == -1)
+    return QModelIndex();
+
+  return index(row, sourceIndex.column());
+}
+
+/*!
+  \brief Returns the index for \a row and \a column. The model is a flat list, so \a parent must be invalid.
+ */
+QModelIndex AlertListSortedProxyModel::index(int row, int column, const QModelIndex& parent) const
+{
+  if (parent.isValid() || row < 0 || row >= m_rows.size() || column != 0)
+    return QModelIndex();
+
+  return createIndex(row, column);
+}
+
+/*!
+  \brief Returns an invalid index: the model is a flat list.
+ */
+QModelIndex AlertListSortedProxyModel::parent(const QModelIndex&) const
+{
+  return QModelIndex();
+}
+
+/*!
+  \brief Returns the number of rows: the number of alerts, or the number of groups when grouped.
+ */
+int AlertListSortedProxyModel::rowCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : m_rows.size();
+}
+
+/*!
+  \brief Returns the number of columns, which is always 1.
+ */
+int AlertListSortedProxyModel::columnCount(const QModelIndex& parent) const
+{
+  return parent.isValid() ? 0 : 1;
+}
+
+/*!
+  \brief Returns the data stored under \a role at \a proxyIndex.
+
+  When the model is grouped, the \c groupCount role returns the number of alerts in the group.
+  Other roles return the data of the first alert in the group.
+ */
+QVariant AlertListSortedProxyModel::data(const QModelIndex& proxyIndex, int role) const
+{
+  if (m_grouped && role == AlertListModel::AlertListRoles::GroupCount)
+  {
+    if (proxyIndex.row() < 0 || proxyIndex.row() >= m_rows.size())
+      return QVariant();
+
+    auto groupIt = m_groups.constFind(m_rows.at(proxyIndex.row()).condition);
+    return groupIt == m_groups.cend() ? 0 : groupIt.value().size();
+  }
+
+  return QAbstractProxyModel::data(proxyIndex, role);
+}
+
+/*!
+  \internal
+
+  Repositions or updates the alerts in the source rows from \a topLeft to \a bottomRight.
+ */
+void AlertListSortedProxyModel::handleSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+  for (int sourceRow = topLeft.row(); sourceRow <= bottomRight.row(); ++sourceRow)
+    updateAlert(m_sourceModel->alertAt(sourceRow));
+}
+
+/*!
+  \internal
+
+  Adds the alerts in the new source rows from \a first to \a last.
+ */
+void AlertListSortedProxyModel::handleSourceRowsInserted(int first, int last)
+{
+  for (int sourceRow = first; sourceRow <= last; ++sourceRow)
+    addAlert(m_sourceModel->alertAt(sourceRow));
+}
+
+/*!
+  \internal
+
+  Removes the alerts in the source rows from \a first to \a last.
+ */
+void AlertListSortedProxyModel::handleSourceRowsAboutToBeRemoved(int first, int last)
+{
+  for (int sourceRow = first; sourceRow <= last; ++sourceRow)
+    removeAlert(m_sourceModel->alertAt(sourceRow));
+}
+
+/*!
+  \internal
+
+  Re-orders every alert in the source model.
+ */
+void AlertListSortedProxyModel::rebuild()
+{
+  m_resetting = true;
+  beginResetModel();
+
+  m_rows.clear();
+  m_keys.clear();
+  m_groups.clear();
+
+  const int count = m_sourceModel->rowCount();
+  for (int sourceRow = 0; sourceRow < count; ++sourceRow)
+    addAlert(m_sourceModel->alertAt(sourceRow));
+
+  endResetModel();
+  m_resetting = false;
+}
+
+/*!
+  \internal
+
+  Adds \a alert to the order and, when grouped, to its group.
+ */
+void AlertListSortedProxyModel::addAlert(AlertConditionData* alert)
+{
+  if (!alert || m_keys.contains(alert))
+    return;
+
+  const SortKey key = sortKey(alert);
+  m_keys.insert(alert, key);
+
+  if (!m_grouped)
+  {
+    insertKey(key);
+    return;
+  }
+
+  SortedAlerts& group = m_groups[key.condition];
+  if (group.isEmpty())
+  {
+    group.insert(key);
+    insertKey(key);
+    return;
+  }
+
+  const SortKey oldFirst = group.at(0);
+  group.insert(key);
+  const SortKey newFirst = group.at(0);
+
+  if (isSameKey(oldFirst, newFirst))
+    keyChanged(newFirst);
+  else
+    moveKey(oldFirst, newFirst);
+}
+
+/*!
+  \internal
+
+  Repositions \a alert if its level or activation has changed, otherwise reports that its row changed.
+ */
+void AlertListSortedProxyModel::updateAlert(AlertConditionData* alert)
+{
+  auto findIt = m_keys.find(alert);
+  if (findIt == m_keys.end())
+    return;
+
+  const SortKey oldKey = findIt.value();
+  const SortKey newKey = sortKey(alert);
+  const bool keyMoved = !isSameKey(oldKey, newKey);
+  if (keyMoved)
+    findIt.value() = newKey;
+
+  if (!m_grouped)
+  {
+    if (keyMoved)
+      moveKey(oldKey, newKey);
+    else
+      keyChanged(newKey);
+
+    return;
+  }
+
+  auto groupIt = m_groups.find(oldKey.condition);
+  if (groupIt == m_groups.end())
+    return;
+
+  SortedAlerts& group = groupIt.value();
+  const SortKey oldFirst = group.at(0);
+  if (keyMoved)
+  {
+    group.remove(oldKey);
+    group.insert(newKey);
+  }
+  const SortKey newFirst = group.at(0);
+
+  if (isSameKey(oldFirst, newFirst))
+    keyChanged(newFirst);
+  else
+    moveKey(oldFirst, newFirst);
+}
+
+/*!
+  \internal
+
+  Removes \a alert from the order and, when grouped, from its group.
+ */
+void AlertListSortedProxyModel::removeAlert(AlertConditionData* alert)
+{
+  auto findIt = m_keys.find(alert);
+  if (findIt == m_keys.end())
+    return;
+
+  // the stored key is used, since the alert may be being destroyed
+  const SortKey key = findIt.value();
+  m_keys.erase(findIt);
+
+  if (!m_grouped)
+  {
+    removeKey(key);
+    return;
+  }
+
+  auto groupIt = m_groups.find(key.condition);
+  if (groupIt == m_groups.end())
+    return;
+
+  SortedAlerts& group = groupIt.value();
+  const SortKey oldFirst = group.at(0);
+  group.remove(key);
+  if (group.isEmpty())
+  {
+    m_groups.erase(groupIt);
+    removeKey(oldFirst);
+    return;
+  }
+
+  const SortKey newFirst = group.at(0);
+  if (isSameKey(oldFirst, newFirst))
+    keyChanged(newFirst);
+  else
+    moveKey(oldFirst, newFirst);
+}
+
+/*!
+  \internal
+
+  Inserts a row for \a key at its position in the order.
+ */
+void AlertListSortedProxyModel::insertKey(const SortKey& key)
+{
+  if (m_resetting)
+  {
+    m_rows.insert(key);
+    return;
+  }
+
+  const int row = m_rows.lowerBound(key);
+  beginInsertRows(QModelIndex(), row, row);
+  m_rows.insert(key);
+  endInsertRows();
+}
+
+/*!
+  \internal
+
+  Moves the row for \a oldKey to the position of \a newKey.
+ */
+void AlertListSortedProxyModel::moveKey(const SortKey& oldKey, const SortKey& newKey)
+{
+  if (m_resetting)
+  {
+    m_rows.remove(oldKey);
+    m_rows.insert(newKey);
+    return;
+  }
+
+  const int oldRow = m_rows.rankOf(oldKey);
+  if (oldRow == -1)
+    return;
+
+  // the position of the new key once the old key has been removed
+  int newRow = m_rows.lowerBound(newKey);
+  if (SortKeyLessThan()(oldKey, newKey))
+    --newRow;
+
+  if (newRow == oldRow)
+  {
+    m_rows.remove(oldKey);
+    m_rows.insert(newKey);
+  }
+  else
+  {
+    // the destination is given relative to the rows before the move
+    beginMoveRows(QModelIndex(), oldRow, oldRow, QModelIndex(), newRow > oldRow ? newRow + 1 : newRow);
+    m_rows.remove(oldKey);
+    m_rows.insert(newKey);
+    endMoveRows();
+  }
+
+  const QModelIndex changedIndex = index(newRow, 0);
+  emit dataChanged(changedIndex, changedIndex);
+}
+
+/*!
+  \internal
+
+  Removes the row for \a key.
+ */
+void AlertListSortedProxyModel::removeKey(const SortKey& key)
+{
+  const int row = m_rows.rankOf(key);
+  if (row == -1)
+    return;
+
+  if (m_resetting)
+  {
+    m_rows.remove(key);
+    return;
+  }
+
+  beginRemoveRows(QModelIndex(), row, row);
+  m_rows.remove(key);
+  endRemoveRows();
+}
+
+/*!
+  \internal
+
+  Reports that the data for the row of \a key has changed.
+ */
+void AlertListSortedProxyModel::keyChanged(const SortKey& key)
+{
+  if (m_resetting)
+    return;
+
+  const int row = m_rows.rankOf(key);
+  if (row == -1)
+    return;
+
+  const QModelIndex changedIndex = index(row, 0);
+  emit dataChanged(changedIndex, changedIndex);
+}
+
+/*!
+  \internal
+
+  Returns the current sort key for \a alert.
+ */
+AlertListSortedProxyModel::SortKey AlertListSortedProxyModel::sortKey(AlertConditionData* alert)
+{
+  SortKey key;
+  key.level = static_cast<int>(alert->level());
+  key.activationOrder = alert->activationOrder();
+  key.alert = alert;
+  key.condition = alert->condition();
+  return key;
+}
+
+/*!
+  \internal
+
+  Returns whether \a a and \a b have the same position in the order.
+ */
+bool AlertListSortedProxyModel::isSameKey(const SortKey& a, const SortKey& b)
+{
+  return a.level == b.level && a.activationOrder == b.activationOrder && a.alert == b.alert;
+}
+
+/*!
+  \internal
+
+  Orders alerts by descending level, then by descending activation order, so that the most
+  recently activated alerts come first.
+ */
+bool AlertListSortedProxyModel::SortKeyLessThan::operator()(const SortKey& a, const SortKey& b) const
+{
+  if (a.level != b.level)
+    return a.level > b.level;
+
+  if (a.activationOrder != b.activationOrder)
+    return a.activationOrder > b.activationOrder;
+
+  return std::less<AlertConditionData*>()(a.alert, b.alert);
+}
+
+} // Dsa
+
+// Signal Documentation
+/*!
+  \fn void AlertListSortedProxyModel::groupedChanged();
+  \brief Signal emitted when the grouping of the model changes.
+ */
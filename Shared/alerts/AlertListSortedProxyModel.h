@@ -0,0 +1,107 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALERTLISTSORTEDPROXYMODEL_H
+#define ALERTLISTSORTEDPROXYMODEL_H
+
+// dsa app headers
+#include "OrderStatisticsTree.h"
+
+// Qt headers
+#include <QAbstractProxyModel>
+#include <QHash>
+#include <QList>
+
+namespace Dsa {
+
+class AlertCondition;
+class AlertConditionData;
+class AlertListProxyModel;
+
+class AlertListSortedProxyModel : public QAbstractProxyModel
+{
+  Q_OBJECT
+
+public:
+
+  AlertListSortedProxyModel(AlertListProxyModel* sourceModel, QObject* parent = nullptr);
+  ~AlertListSortedProxyModel();
+
+  bool isGrouped() const;
+  void setGrouped(bool grouped);
+
+  AlertConditionData* alertAt(int row) const;
+  QList<AlertConditionData*> alertsAt(int row) const;
+
+  // QAbstractProxyModel interface
+  QModelIndex mapToSource(const QModelIndex& proxyIndex) const override;
+  QModelIndex mapFromSource(const QModelIndex& sourceIndex) const override;
+
+  // QAbstractItemModel interface
+  QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+  QModelIndex parent(const QModelIndex& child) const override;
+  int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex& proxyIndex, int role) const override;
+
+signals:
+  void groupedChanged();
+
+private:
+  // the position of an alert in the model: by descending level, then most recently activated
+  struct SortKey
+  {
+    int level = 0;
+    quint64 activationOrder = 0;
+    AlertConditionData* alert = nullptr;
+    AlertCondition* condition = nullptr; // the group of the alert, which is not part of the order
+  };
+
+  struct SortKeyLessThan
+  {
+    bool operator()(const SortKey& a, const SortKey& b) const;
+  };
+
+  using SortedAlerts = OrderStatisticsTree<SortKey, SortKeyLessThan>;
+
+  void handleSourceDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+  void handleSourceRowsInserted(int first, int last);
+  void handleSourceRowsAboutToBeRemoved(int first, int last);
+  void rebuild();
+
+  void addAlert(AlertConditionData* alert);
+  void updateAlert(AlertConditionData* alert);
+  void removeAlert(AlertConditionData* alert);
+
+  void insertKey(const SortKey& key);
+  void moveKey(const SortKey& oldKey, const SortKey& newKey);
+  void removeKey(const SortKey& key);
+  void keyChanged(const SortKey& key);
+
+  static SortKey sortKey(AlertConditionData* alert);
+  static bool isSameKey(const SortKey& a, const SortKey& b);
+
+  AlertListProxyModel* m_sourceModel;
+  bool m_grouped = false;
+  bool m_resetting = false;
+  SortedAlerts m_rows; // the alerts represented by each row: every alert, or the first alert of each group
+  QHash<AlertConditionData*, SortKey> m_keys;
+  QHash<AlertCondition*, SortedAlerts> m_groups;
+};
+
+} // Dsa
+
+#endif // ALERTLISTSORTEDPROXYMODEL_H
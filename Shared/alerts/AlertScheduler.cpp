@@ -0,0 +1,299 @@
+
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+// PCH header
+#include "pch.hpp"
+
+#include "AlertScheduler.h"
+
+// dsa app headers
+#include "AlertCondition.h"
+#include "AlertLevel.h"
+
+// Qt headers
+#include <QElapsedTimer>
+#include <QTimer>
+
+// STL headers
+#include <cmath>
+
+namespace Dsa {
+
+/*!
+  \class Dsa::AlertScheduler
+  \inmodule Dsa
+  \inherits QObject
+  \brief Schedules the evaluation of changed \l AlertCondition data at a fixed rate.
+
+  Rather than running a query each time a source or target reports a change, each
+  \l AlertCondition records its changed data and asks the scheduler for an evaluation. Changes
+  made between ticks are coalesced, so a track which reports several updates in quick
+  succession is only evaluated once.
+
+  The scheduler runs two lanes:
+  \list
+    \li A tick at \l rate (4 per second by default) which evaluates every pending condition.
+    \li A tick at \l criticalRate (20 per second by default) which evaluates pending conditions
+    with an \l AlertLevel of \c Critical.
+  \endlist
+
+  Each tick stops once \l tickBudget milliseconds have been spent, so that alert evaluation
+  cannot starve rendering. Any remaining work is carried over to the next tick.
+
+  When \l isConcurrent is \c true, each tick only captures snapshots of the changed source
+  locations and the target geometries. The queries are run on the global QThreadPool and only
+  the resulting changes of state are passed back to the \l AlertConditionData objects.
+
+  Setting a non-negative \l localFrameTolerance enables short-range distance tests to be measured
+  in a local tangent plane (see \l GeodesicUtils::LocalFrame) whenever the error that introduces
+  is within the tolerance. Otherwise distances are measured on the sphere.
+
+  \note Timers only run while there is work pending.
+ */
+
+/*!
+  \brief Static method to return a singleton instance of the scheduler.
+ */
+AlertScheduler* AlertScheduler::instance()
+{
+  static AlertScheduler s_instance;
+
+  return &s_instance;
+}
+
+/*!
+  \brief Constructor taking an optional \a parent.
+ */
+AlertScheduler::AlertScheduler(QObject* parent):
+  QObject(parent),
+  m_timer(new QTimer(this)),
+  m_criticalTimer(new QTimer(this))
+{
+  m_timer->setSingleShot(true);
+  m_timer->setInterval(intervalForRate(m_rate));
+  connect(m_timer, &QTimer::timeout, this, [this]()
+  {
+    handleTick(false);
+  });
+
+  m_criticalTimer->setSingleShot(true);
+  m_criticalTimer->setInterval(intervalForRate(m_criticalRate));
+  connect(m_criticalTimer, &QTimer::timeout, this, [this]()
+  {
+    handleTick(true);
+  });
+}
+
+/*!
+  \brief Destructor.
+ */
+AlertScheduler::~AlertScheduler()
+{
+}
+
+/*!
+  \brief Adds \a condition to the set of conditions to be evaluated on the next tick.
+
+  Scheduling a condition which is already pending has no effect.
+ */
+void AlertScheduler::scheduleEvaluation(AlertCondition* condition)
+{
+  if (!condition)
+    return;
+
+  if (!m_pendingConditions.contains(condition))
+    m_pendingConditions.append(condition);
+
+  startTimers();
+}
+
+/*!
+  \brief Removes \a condition from the set of conditions to be evaluated.
+ */
+void AlertScheduler::cancelEvaluation(AlertCondition* condition)
+{
+  m_pendingConditions.removeAll(condition);
+}
+
+/*!
+  \brief Returns the number of ticks per second for evaluating all conditions.
+ */
+double AlertScheduler::rate() const
+{
+  return m_rate;
+}
+
+/*!
+  \brief Sets the number of ticks per second for evaluating all conditions to \a rate.
+ */
+void AlertScheduler::setRate(double rate)
+{
+  if (rate <= 0.0 || rate == m_rate)
+    return;
+
+  m_rate = rate;
+  m_timer->setInterval(intervalForRate(m_rate));
+}
+
+/*!
+  \brief Returns the number of ticks per second for evaluating \c Critical conditions.
+ */
+double AlertScheduler::criticalRate() const
+{
+  return m_criticalRate;
+}
+
+/*!
+  \brief Sets the number of ticks per second for evaluating \c Critical conditions to \a criticalRate.
+ */
+void AlertScheduler::setCriticalRate(double criticalRate)
+{
+  if (criticalRate <= 0.0 || criticalRate == m_criticalRate)
+    return;
+
+  m_criticalRate = criticalRate;
+  m_criticalTimer->setInterval(intervalForRate(m_criticalRate));
+}
+
+/*!
+  \brief Returns the maximum time, in milliseconds, to spend evaluating conditions in a single tick.
+ */
+int AlertScheduler::tickBudget() const
+{
+  return m_tickBudget;
+}
+
+/*!
+  \brief Sets the maximum time, in milliseconds, to spend evaluating conditions in a single tick to \a tickBudget.
+ */
+void AlertScheduler::setTickBudget(int tickBudget)
+{
+  if (tickBudget <= 0)
+    return;
+
+  m_tickBudget = tickBudget;
+}
+
+/*!
+  \brief Returns whether conditions are evaluated on the global QThreadPool.
+ */
+bool AlertScheduler::isConcurrent() const
+{
+  return m_concurrent;
+}
+
+/*!
+  \brief Sets whether conditions are evaluated on the global QThreadPool to \a concurrent.
+ */
+void AlertScheduler::setConcurrent(bool concurrent)
+{
+  m_concurrent = concurrent;
+}
+
+/*!
+  \brief Returns the largest error, in meters, allowed for distances measured in a local frame.
+
+  A negative value (the default) means that local frames are not used.
+ */
+double AlertScheduler::localFrameTolerance() const
+{
+  return m_localFrameTolerance;
+}
+
+/*!
+  \brief Sets the largest error, in meters, allowed for distances measured in a local frame to
+  \a tolerance.
+
+  A negative \a tolerance disables local frames.
+ */
+void AlertScheduler::setLocalFrameTolerance(double tolerance)
+{
+  m_localFrameTolerance = tolerance;
+}
+
+/*!
+  \internal
+
+  Evaluates the pending conditions until the tick budget is spent. When \a criticalOnly is
+  \c true, only conditions with a level of \c Critical are evaluated.
+ */
+void AlertScheduler::handleTick(bool criticalOnly)
+{
+  QElapsedTimer elapsed;
+  elapsed.start();
+
+  // evaluating a condition can cause conditions to be scheduled or removed, so iterate over a copy
+  const QList<AlertCondition*> pendingConditions = m_pendingConditions;
+  for (AlertCondition* condition : pendingConditions)
+  {
+    if (elapsed.elapsed() >= m_tickBudget)
+      break;
+
+    if (!m_pendingConditions.contains(condition))
+      continue;
+
+    if (criticalOnly && condition->level() != AlertLevel::Critical)
+      continue;
+
+    condition->evaluatePendingData(elapsed, m_tickBudget);
+
+    // the condition may have received new changes while it was being evaluated, or run out of budget.
+    // Either way it moves to the back of the queue so that other conditions are not starved
+    m_pendingConditions.removeAll(condition);
+    if (condition->hasPendingData())
+      m_pendingConditions.append(condition);
+  }
+
+  startTimers();
+}
+
+/*!
+  \internal
+
+  Starts the timers for any lanes which have pending work.
+ */
+void AlertScheduler::startTimers()
+{
+  if (m_pendingConditions.isEmpty())
+    return;
+
+  if (!m_timer->isActive())
+    m_timer->start();
+
+  if (m_criticalTimer->isActive())
+    return;
+
+  for (AlertCondition* condition : qAsConst(m_pendingConditions))
+  {
+    if (condition->level() != AlertLevel::Critical)
+      continue;
+
+    m_criticalTimer->start();
+    break;
+  }
+}
+
+/*!
+  \internal
+
+  Returns the timer interval in milliseconds for \a rate ticks per second.
+ */
+int AlertScheduler::intervalForRate(double rate)
+{
+  return static_cast<int>(std::lround(1000.0 / rate));
+}
+
+} // Dsa
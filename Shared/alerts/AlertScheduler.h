@@ -0,0 +1,77 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALERTSCHEDULER_H
+#define ALERTSCHEDULER_H
+
+// Qt headers
+#include <QList>
+#include <QObject>
+
+class QTimer;
+
+namespace Dsa {
+
+class AlertCondition;
+
+class AlertScheduler : public QObject
+{
+  Q_OBJECT
+
+public:
+  static AlertScheduler* instance();
+
+  ~AlertScheduler();
+
+  void scheduleEvaluation(AlertCondition* condition);
+  void cancelEvaluation(AlertCondition* condition);
+
+  double rate() const;
+  void setRate(double rate);
+
+  double criticalRate() const;
+  void setCriticalRate(double criticalRate);
+
+  int tickBudget() const;
+  void setTickBudget(int tickBudget);
+
+  bool isConcurrent() const;
+  void setConcurrent(bool concurrent);
+
+  double localFrameTolerance() const;
+  void setLocalFrameTolerance(double tolerance);
+
+private:
+  explicit AlertScheduler(QObject* parent = nullptr);
+
+  void handleTick(bool criticalOnly);
+  void startTimers();
+
+  static int intervalForRate(double rate);
+
+  QTimer* m_timer = nullptr;
+  QTimer* m_criticalTimer = nullptr;
+  QList<AlertCondition*> m_pendingConditions;
+  double m_rate = 4.0;
+  double m_criticalRate = 20.0;
+  int m_tickBudget = 8;
+  bool m_concurrent = false;
+  double m_localFrameTolerance = -1.0;
+};
+
+} // Dsa
+
+#endif // ALERTSCHEDULER_H
@@ -19,16 +19,46 @@
 
 #include "AlertSource.h"
 
+// dsa app headers
+#include "ProjectionUtils.h"
+
+// Qt headers
+#include <QHash>
+
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
 
+namespace
+{
+// the attribute names which have been resolved to slots, where the slot is the index of the name
+struct AttributeSlotRegistry
+{
+  QHash<QString, int> slotOfKey;
+  QStringList keys;
+};
+
+AttributeSlotRegistry& attributeSlotRegistry()
+{
+  static AttributeSlotRegistry registry;
+  return registry;
+}
+}
+
 /*!
   \class Dsa::AlertSource
   \inmodule Dsa
   \inherits QObject
   \brief Represents a source (generally a real-time feed) for an \l AlertCondition.
 
+  Conditions which test attributes can resolve an attribute name once, using \l attributeSlot,
+  and then read the value of the attribute through \l attributeSlotValue. The value is converted
+  into an \l AttributeValue the first time it is read after it changes, rather than being looked up
+  by name and converted every time it is tested.
+
+  Similarly, the location of the source is projected to WGS84 by \l wgs84Location the first time
+  it is requested after the geometry changes.
+
   \note This is an abstract base type.
   */
 
@@ -38,7 +68,8 @@ namespace Dsa {
 AlertSource::AlertSource(QObject* parent):
   QObject(parent)
 {
-
+  // connected before any condition so that the cached values are never stale when a condition is notified
+  connect(this, &AlertSource::dataChanged, this, &AlertSource::invalidateCaches);
 }
 
 /*!
@@ -49,12 +80,105 @@ AlertSource::~AlertSource()
   emit noLongerValid();
 }
 
+/*!
+  \brief Returns the slot of the attribute named \a key.
+
+  Slots are shared by every source, so the slot of an attribute can be resolved once (for example,
+  when a condition is created) and used to read the attribute of any source with
+  \l attributeSlotValue.
+
+  \note This should be called from the main thread.
+ */
+int AlertSource::attributeSlot(const QString& key)
+{
+  AttributeSlotRegistry& registry = attributeSlotRegistry();
+  auto findIt = registry.slotOfKey.constFind(key);
+  if (findIt != registry.slotOfKey.constEnd())
+    return findIt.value();
+
+  const int slot = registry.keys.size();
+  registry.slotOfKey.insert(key, slot);
+  registry.keys.append(key);
+  return slot;
+}
+
+/*!
+  \brief Returns the value of the attribute at \a slot, as returned by \l attributeSlot.
+
+  The value is read and converted the first time it is requested after the attribute changes.
+ */
+const AttributeValue& AlertSource::attributeSlotValue(int slot) const
+{
+  if (slot >= m_slotValues.size())
+  {
+    m_slotValues.resize(slot + 1);
+    m_slotResolved.resize(slot + 1);
+  }
+
+  if (!m_slotResolved.at(slot))
+  {
+    m_slotValues[slot] = AttributeValue::fromVariant(value(attributeSlotRegistry().keys.at(slot)));
+    m_slotResolved[slot] = true;
+  }
+
+  return m_slotValues.at(slot);
+}
+
+/*!
+  \brief Returns the \l location of the source in WGS84.
+
+  The projected location is cached until the geometry of the source changes.
+ */
+Point AlertSource::wgs84Location() const
+{
+  if (!m_wgs84LocationResolved)
+  {
+    m_wgs84Location = ProjectionUtils::toWgs84(location());
+    m_wgs84LocationResolved = true;
+  }
+
+  return m_wgs84Location;
+}
+
+/*!
+  \brief internal
+
+  Discards the cached WGS84 location if \a changes include the geometry, and the cached values of
+  the attributes in \a changedKeys, or of every attribute if the list is empty.
+ */
+void AlertSource::invalidateCaches(AlertChanges changes, const QStringList& changedKeys)
+{
+  if (changes.testFlag(AlertChange::Geometry))
+    m_wgs84LocationResolved = false;
+
+  if (!changes.testFlag(AlertChange::Attributes) || m_slotResolved.isEmpty())
+    return;
+
+  if (changedKeys.isEmpty())
+  {
+    m_slotResolved.fill(false);
+    return;
+  }
+
+  const QHash<QString, int>& slotOfKey = attributeSlotRegistry().slotOfKey;
+  for (const QString& key : changedKeys)
+  {
+    auto findIt = slotOfKey.constFind(key);
+    if (findIt != slotOfKey.constEnd() && findIt.value() < m_slotResolved.size())
+      m_slotResolved[findIt.value()] = false;
+  }
+}
+
 } // Dsa
 
 // Signal Documentation
 /*!
-  \fn void AlertSource::dataChanged();
+  \fn void AlertSource::dataChanged(Dsa::AlertChanges changes, const QStringList& changedKeys);
   \brief Signal emitted when alert source's data changes.
+
+  The kinds of change are given by \a changes. When they include \c AlertChange::Attributes,
+  \a changedKeys lists the attributes which changed: an empty list means that any attribute
+  may have changed.
  */
 
 /*!
@@ -17,12 +17,18 @@
 #ifndef ALERTSOURCE_H
 #define ALERTSOURCE_H
 
+// dsa app headers
+#include "AlertChange.h"
+#include "AttributePredicate.h"
+
 // C++ API headers
 #include "Point.h"
 
 // Qt headers
 #include <QObject>
+#include <QStringList>
 #include <QVariant>
+#include <QVector>
 
 namespace Dsa {
 
@@ -39,9 +45,22 @@ public:
 
   virtual void setSelected(bool selected) = 0;
 
+  static int attributeSlot(const QString& key);
+  const AttributeValue& attributeSlotValue(int slot) const;
+
+  Esri::ArcGISRuntime::Point wgs84Location() const;
+
 signals:
-  void dataChanged();
+  void dataChanged(Dsa::AlertChanges changes, const QStringList& changedKeys);
   void noLongerValid();
+
+private:
+  void invalidateCaches(AlertChanges changes, const QStringList& changedKeys);
+
+  mutable QVector<AttributeValue> m_slotValues;
+  mutable QVector<bool> m_slotResolved;
+  mutable Esri::ArcGISRuntime::Point m_wgs84Location;
+  mutable bool m_wgs84LocationResolved = false;
 };
 
 } // Dsa
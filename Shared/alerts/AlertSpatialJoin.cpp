@@ -0,0 +1,457 @@
+
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+// PCH header
+#include "pch.hpp"
+
+#include "AlertSpatialJoin.h"
+
+// dsa app headers
+#include "AlertTarget.h"
+#include "GeodesicUtils.h"
+#include "PreparedPolygon.h"
+#include "SpatialHashGrid.h"
+
+// C++ API headers
+#include "Envelope.h"
+#include "Point.h"
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+// slacks are reduced by this factor, to allow for the approximations made when measuring distances
+constexpr double SlackSafetyFactor = 0.9;
+
+// a source location with the WGS84 bounds that a target must overlap to be tested against it
+struct SourceEntry
+{
+  int index = -1;
+  double xMin = 0.0;
+  double yMin = 0.0;
+  double xMax = 0.0;
+  double yMax = 0.0;
+};
+
+// the source entries sorted by their minimum longitude, so that the entries overlapping a target
+// can be found with a binary search rather than testing every source against every target
+class SourceSweep
+{
+public:
+  void append(const SourceEntry& entry)
+  {
+    // entries which cross the antimeridian are tested against every target
+    if (entry.xMin < -180.0 || entry.xMax > 180.0)
+      m_wrapped.append(entry);
+    else
+      m_sorted.append(entry);
+
+    m_maxWidth = std::max(m_maxWidth, entry.xMax - entry.xMin);
+    m_xMin = std::max(-180.0, std::min(m_xMin, entry.xMin));
+    m_yMin = std::min(m_yMin, entry.yMin);
+    m_xMax = std::min(180.0, std::max(m_xMax, entry.xMax));
+    m_yMax = std::max(m_yMax, entry.yMax);
+    if (!m_wrapped.isEmpty())
+    {
+      m_xMin = -180.0;
+      m_xMax = 180.0;
+    }
+  }
+
+  void sort()
+  {
+    std::sort(m_sorted.begin(), m_sorted.end(), [](const SourceEntry& a, const SourceEntry& b)
+    {
+      return a.xMin < b.xMin;
+    });
+  }
+
+  bool isEmpty() const
+  {
+    return m_sorted.isEmpty() && m_wrapped.isEmpty();
+  }
+
+  int count() const
+  {
+    return m_sorted.size() + m_wrapped.size();
+  }
+
+  // the WGS84 area covering every entry
+  Envelope extent() const
+  {
+    return Envelope(m_xMin, m_yMin, m_xMax, m_yMax, SpatialReference::wgs84());
+  }
+
+  // calls visitor with the index of each source whose bounds overlap the target bounds
+  template <typename Visitor>
+  void visitOverlapping(const Envelope& targetExtent, Visitor&& visitor) const
+  {
+    if (targetExtent.isEmpty())
+      return;
+
+    const double xMin = targetExtent.xMin();
+    const double yMin = targetExtent.yMin();
+    const double xMax = targetExtent.xMax();
+    const double yMax = targetExtent.yMax();
+
+    // only entries starting within the widest entry of the target can overlap it
+    auto it = std::lower_bound(m_sorted.cbegin(), m_sorted.cend(), xMin - m_maxWidth, [](const SourceEntry& entry, double x)
+    {
+      return entry.xMin < x;
+    });
+
+    for (; it != m_sorted.cend() && it->xMin <= xMax; ++it)
+    {
+      if (it->xMax >= xMin && it->yMin <= yMax && it->yMax >= yMin)
+        visitor(it->index);
+    }
+
+    for (const SourceEntry& entry : m_wrapped)
+    {
+      if (entry.yMin > yMax || entry.yMax < yMin)
+        continue;
+
+      for (double shift : {-360.0, 0.0, 360.0})
+      {
+        if (entry.xMin + shift <= xMax && entry.xMax + shift >= xMin)
+        {
+          visitor(entry.index);
+          break;
+        }
+      }
+    }
+  }
+
+private:
+  QVector<SourceEntry> m_sorted;
+  QVector<SourceEntry> m_wrapped;
+  double m_maxWidth = 0.0;
+  double m_xMin = 180.0;
+  double m_yMin = 90.0;
+  double m_xMax = -180.0;
+  double m_yMax = -90.0;
+};
+
+// adds each of the non-empty source locations to the sweep, with their bounds extended by distance meters
+void buildSweep(const QVector<double>& lons, const QVector<double>& lats, double distance, SourceSweep& sweep)
+{
+  const int count = std::min(lons.size(), lats.size());
+  for (int i = 0; i < count; ++i)
+  {
+    if (std::isnan(lons.at(i)) || std::isnan(lats.at(i)))
+      continue;
+
+    SourceEntry entry;
+    entry.index = i;
+    GeodesicUtils::boundsForDistance(lons.at(i), lats.at(i), distance, entry.xMin, entry.yMin, entry.xMax, entry.yMax);
+    sweep.append(entry);
+  }
+}
+}
+
+/*!
+  \namespace Dsa::AlertSpatialJoin
+  \inmodule Dsa
+  \brief Functions to evaluate a spatial condition for a batch of source locations in one pass.
+
+  Rather than querying the \l AlertTarget once for each source, the target geometries covering
+  all of the sources are captured once in a \l TargetSnapshot. Each target geometry is then only
+  tested against the sources near to it: for \l withinDistance the sources are bucketed into a
+  \l SpatialHashGrid with cells sized to the distance, and only the cells neighbouring each target
+  are visited.
+
+  A snapshot does not refer to the target, so the join functions can be called from any thread.
+
+  Source locations are supplied as packed WGS84 coordinates. A location with a \c NaN coordinate
+  is treated as empty and never matches.
+ */
+
+/*!
+  \struct Dsa::AlertSpatialJoin::TargetSnapshot
+  \inmodule Dsa
+  \brief The WGS84 geometries of an \l AlertTarget covering an area, with their extents and
+  packed coordinates.
+
+  \sa snapshotTarget
+ */
+
+/*!
+  \brief Returns the WGS84 area which a target must overlap to be within \a distance meters of any of
+  the source locations in \a lons and \a lats.
+
+  Returns an empty envelope if there are no source locations.
+ */
+Envelope AlertSpatialJoin::searchArea(const QVector<double>& lons, const QVector<double>& lats, double distance)
+{
+  SourceSweep sweep;
+  buildSweep(lons, lats, std::max(0.0, distance), sweep);
+  if (sweep.isEmpty())
+    return Envelope();
+
+  return sweep.extent();
+}
+
+/*!
+  \brief Returns a snapshot of the geometries of \a target in the WGS84 \a area.
+
+  The snapshot should be taken on the thread which owns the \a target.
+ */
+AlertSpatialJoin::TargetSnapshot AlertSpatialJoin::snapshotTarget(const AlertTarget* target, const Envelope& area)
+{
+  TargetSnapshot snapshot;
+  if (!target || area.isEmpty())
+    return snapshot;
+
+  target->visitTargetGeometries(area, [&snapshot](const Geometry& targetWgs84)
+  {
+    GeodesicUtils::PackedGeometry packed;
+    GeodesicUtils::pack(targetWgs84, packed);
+
+    snapshot.geometries.append(targetWgs84);
+    snapshot.extents.append(targetWgs84.extent());
+    snapshot.packedGeometries.append(packed);
+    return true;
+  });
+
+  return snapshot;
+}
+
+/*!
+  \brief Returns a snapshot of the polygons of \a target in the WGS84 \a area, for \l withinArea.
+
+  The polygons are prepared by the \a target, which can keep them between snapshots. The snapshot
+  only shares them, so it is cheap to take for each evaluation.
+
+  The snapshot should be taken on the thread which owns the \a target.
+ */
+AlertSpatialJoin::TargetSnapshot AlertSpatialJoin::snapshotTargetPolygons(const AlertTarget* target, const Envelope& area)
+{
+  TargetSnapshot snapshot;
+  if (!target || area.isEmpty())
+    return snapshot;
+
+  target->visitTargetPolygons(area, [&snapshot](const std::shared_ptr<const PreparedPolygon>& polygon)
+  {
+    snapshot.extents.append(Envelope(polygon->xMin(), polygon->yMin(), polygon->xMax(), polygon->yMax(), SpatialReference::wgs84()));
+    snapshot.polygons.append(polygon);
+    return true;
+  });
+
+  return snapshot;
+}
+
+/*!
+  \brief Sets each element of \a results to whether the source location at the same index of
+  \a lons and \a lats lies within \a distance meters of a geometry of the \a target snapshot.
+
+  If \a slacks is supplied, each of its elements is set to the distance, in meters, that the source
+  can move before the result could change (its \e slack). For a matching source this is how much
+  nearer to \a distance its matching target is. For any other source it is how much further than
+  \a distance the nearest target is, up to \l SlackHorizon. To measure slacks, the snapshot must
+  cover the \l searchArea for \a distance plus \l SlackHorizon.
+
+  Slacks are conservative: they are reduced by a safety margin to allow for the approximation of
+  geodesic distances.
+
+  If \a localFrameTolerance is not negative, the distances from each source to packed targets are
+  measured in a \l GeodesicUtils::LocalFrame at the source, unless its error bound for the search
+  distance exceeds the tolerance. Slacks measured in a frame are also reduced by its error bound.
+
+  Each target is only tested against the sources in the grid cells near to it, so the cost grows
+  with the number of sources and targets, rather than with their product, unless they are all
+  within the distance of each other.
+ */
+void AlertSpatialJoin::withinDistance(const TargetSnapshot& target, double distance, const QVector<double>& lons, const QVector<double>& lats, QVector<bool>& results,
+                                      QVector<double>* slacks, double localFrameTolerance)
+{
+  const int count = std::min(lons.size(), lats.size());
+  results.fill(false, count);
+  if (slacks)
+    slacks->fill(0.0, count);
+
+  if (distance < 0.0)
+    return;
+
+  // the sources are bucketed into cells sized to the threshold distance, and the slack horizon
+  // so that the nearest target beyond the threshold is found
+  const double horizon = slacks ? SlackHorizon : 0.0;
+  const double searchDistance = distance + horizon;
+  SpatialHashGrid<int> grid(searchDistance);
+  for (int i = 0; i < count; ++i)
+  {
+    if (!std::isnan(lons.at(i)) && !std::isnan(lats.at(i)))
+      grid.insert(i, lons.at(i), lats.at(i));
+  }
+
+  if (grid.isEmpty())
+    return;
+
+  // a local frame for each source, which is only used if its error is within the tolerance
+  std::vector<GeodesicUtils::LocalFrame> frames;
+  if (localFrameTolerance >= 0.0)
+  {
+    frames.reserve(count);
+    for (int i = 0; i < count; ++i)
+      frames.emplace_back(lons.at(i), lats.at(i), searchDistance);
+  }
+
+  // the distance to the nearest target, for sources which do not match
+  QVector<double> nearest;
+  if (slacks)
+    nearest.fill(searchDistance, count);
+
+  int remaining = grid.count();
+  const int targetCount = target.geometries.size();
+  for (int targetIndex = 0; targetIndex < targetCount && (remaining > 0 || slacks); ++targetIndex)
+  {
+    const Envelope& targetExtent = target.extents.at(targetIndex);
+    if (targetExtent.isEmpty())
+      continue;
+
+    const Geometry& targetWgs84 = target.geometries.at(targetIndex);
+    const GeodesicUtils::PackedGeometry& packed = target.packedGeometries.at(targetIndex);
+
+    // only the sources in the cells neighbouring the target are tested
+    grid.visitNear(targetExtent.xMin(), targetExtent.yMin(), targetExtent.xMax(), targetExtent.yMax(), searchDistance,
+                   [&](int index, double lon, double lat)
+    {
+      if (results.at(index))
+        return;
+
+      const bool useFrame = !frames.empty() && !packed.isEmpty() && frames[index].isWithinTolerance(localFrameTolerance);
+      double targetDistance = -1.0;
+      double error = 0.0;
+      if (useFrame)
+      {
+        targetDistance = frames[index].distanceToPacked(packed);
+        error = frames[index].errorBound();
+      }
+      else
+      {
+        targetDistance = !packed.isEmpty() ? GeodesicUtils::distanceToPacked(lon, lat, packed)
+                                           : GeodesicUtils::distanceToGeometry(Point(lon, lat, SpatialReference::wgs84()), targetWgs84);
+      }
+
+      if (targetDistance < 0.0)
+        return;
+
+      if (targetDistance > distance)
+      {
+        if (slacks)
+          nearest[index] = std::min(nearest.at(index), std::max(distance, targetDistance - error));
+
+        return;
+      }
+
+      results[index] = true;
+      --remaining;
+
+      // the source remains within distance of this target until it has moved the difference
+      if (slacks)
+        (*slacks)[index] = std::max(0.0, SlackSafetyFactor * (distance - targetDistance) - error);
+    });
+  }
+
+  if (!slacks)
+    return;
+
+  for (int i = 0; i < count; ++i)
+  {
+    if (!results.at(i) && !std::isnan(lons.at(i)) && !std::isnan(lats.at(i)))
+      (*slacks)[i] = SlackSafetyFactor * (nearest.at(i) - distance);
+  }
+}
+
+/*!
+  \brief Sets each element of \a results to whether the source location at the same index of
+  \a lons and \a lats lies within a polygon of the \a target snapshot.
+
+  The snapshot should be taken with \l snapshotTargetPolygons. Each location is tested using the
+  \l PreparedPolygon, which only touches the edges near to it.
+
+  If \a slacks is supplied, each of its elements is set to the distance, in meters, that the source
+  can move before the result could change (its \e slack). This is the distance to the boundary of
+  the containing polygon or, for a source which is not contained, to the nearest boundary, up to
+  \l SlackHorizon. To measure slacks, the snapshot must cover the \l searchArea for \l SlackHorizon.
+ */
+void AlertSpatialJoin::withinArea(const TargetSnapshot& target, const QVector<double>& lons, const QVector<double>& lats, QVector<bool>& results,
+                                  QVector<double>* slacks)
+{
+  const int count = std::min(lons.size(), lats.size());
+  results.fill(false, count);
+  if (slacks)
+    slacks->fill(0.0, count);
+
+  const double horizon = slacks ? SlackHorizon : 0.0;
+  SourceSweep sweep;
+  buildSweep(lons, lats, horizon, sweep);
+  if (sweep.isEmpty())
+    return;
+
+  sweep.sort();
+
+  // the distance to the nearest boundary, for sources which are not contained
+  QVector<double> nearest;
+  if (slacks)
+    nearest.fill(horizon, count);
+
+  int remaining = sweep.count();
+  const int targetCount = target.polygons.size();
+  for (int targetIndex = 0; targetIndex < targetCount && (remaining > 0 || slacks); ++targetIndex)
+  {
+    const PreparedPolygon& polygon = *target.polygons.at(targetIndex);
+    sweep.visitOverlapping(target.extents.at(targetIndex), [&](int index)
+    {
+      if (results.at(index))
+        return;
+
+      const double lon = lons.at(index);
+      const double lat = lats.at(index);
+      if (!polygon.contains(lon, lat))
+      {
+        if (slacks)
+          nearest[index] = polygon.boundaryDistance(lon, lat, nearest.at(index));
+
+        return;
+      }
+
+      results[index] = true;
+      --remaining;
+
+      // the source remains within this polygon until it has moved as far as its boundary
+      if (slacks)
+        (*slacks)[index] = SlackSafetyFactor * polygon.boundaryDistance(lon, lat, horizon);
+    });
+  }
+
+  if (!slacks)
+    return;
+
+  for (int i = 0; i < count; ++i)
+  {
+    if (!results.at(i) && !std::isnan(lons.at(i)) && !std::isnan(lats.at(i)))
+      (*slacks)[i] = SlackSafetyFactor * nearest.at(i);
+  }
+}
+
+} // Dsa
@@ -0,0 +1,64 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ALERTSPATIALJOIN_H
+#define ALERTSPATIALJOIN_H
+
+// dsa app headers
+#include "GeodesicUtils.h"
+
+// C++ API headers
+#include "Envelope.h"
+#include "Geometry.h"
+
+// Qt headers
+#include <QList>
+#include <QVector>
+
+// STL headers
+#include <memory>
+
+namespace Dsa {
+
+class AlertTarget;
+class PreparedPolygon;
+
+namespace AlertSpatialJoin
+{
+  // the WGS84 target geometries covering an area, captured so that they can be tested on any thread
+  struct TargetSnapshot
+  {
+    QList<Esri::ArcGISRuntime::Geometry> geometries;
+    QVector<Esri::ArcGISRuntime::Envelope> extents;
+    QVector<GeodesicUtils::PackedGeometry> packedGeometries; // empty for geometry which cannot be packed
+    QVector<std::shared_ptr<const PreparedPolygon>> polygons; // only populated by snapshotTargetPolygons
+  };
+
+  // the largest slack, in meters: targets further than this from a decision boundary are not measured
+  constexpr double SlackHorizon = 1000.0;
+
+  Esri::ArcGISRuntime::Envelope searchArea(const QVector<double>& lons, const QVector<double>& lats, double distance);
+  TargetSnapshot snapshotTarget(const AlertTarget* target, const Esri::ArcGISRuntime::Envelope& area);
+  TargetSnapshot snapshotTargetPolygons(const AlertTarget* target, const Esri::ArcGISRuntime::Envelope& area);
+  void withinDistance(const TargetSnapshot& target, double distance, const QVector<double>& lons, const QVector<double>& lats, QVector<bool>& results,
+                      QVector<double>* slacks = nullptr, double localFrameTolerance = -1.0);
+  void withinArea(const TargetSnapshot& target, const QVector<double>& lons, const QVector<double>& lats, QVector<bool>& results,
+                  QVector<double>* slacks = nullptr);
+}
+
+} // Dsa
+
+#endif // ALERTSPATIALJOIN_H
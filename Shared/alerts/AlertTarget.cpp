@@ -20,6 +20,18 @@
 
 #include "AlertTarget.h"
 
+// dsa app headers
+#include "GeodesicUtils.h"
+#include "GeometryQuadtree.h"
+#include "PreparedPolygon.h"
+#include "ProjectionUtils.h"
+
+// C++ API headers
+#include "Envelope.h"
+#include "Point.h"
+
+using namespace Esri::ArcGISRuntime;
+
 namespace Dsa {
 
 /*!
@@ -47,6 +59,127 @@ AlertTarget::~AlertTarget()
   emit noLongerValid();
 }
 
+/*!
+  \brief Calls \a visitor with the WGS84 geometry of each target in the \a targetArea.
+
+  The \a visitor should return \c false to stop visiting any further geometry.
+
+  If the target has a \l quadtree, its cached WGS84 geometry is visited directly. Otherwise each of
+  the \l targetGeometries is projected to WGS84.
+
+  \note No exact intersection tests are carried out against the \a targetArea.
+ */
+void AlertTarget::visitTargetGeometries(const Envelope& targetArea, const GeometryVisitor& visitor) const
+{
+  if (const GeometryQuadtree* index = quadtree())
+  {
+    index->visitCandidates(targetArea, [&visitor](const Geometry& wgs84Geometry, const GeometryQuadtree::Bounds&)
+    {
+      return visitor(wgs84Geometry);
+    });
+    return;
+  }
+
+  const QList<Geometry> geometries = targetGeometries(targetArea);
+  for (const Geometry& geometry : geometries)
+  {
+    if (!visitor(ProjectionUtils::toWgs84(geometry)))
+      return;
+  }
+}
+
+/*!
+  \brief Calls \a visitor with a \l PreparedPolygon for each polygon target in the \a targetArea.
+
+  The \a visitor should return \c false to stop visiting any further polygons.
+
+  If the target has a \l quadtree, each polygon is only prepared once for each change to its
+  geometry. Otherwise each of the polygons from \l visitTargetGeometries is prepared for every call.
+  Other types which cache their geometry should override this to keep the prepared polygons, so
+  that containment tests do not depend on the number of vertices.
+
+  \note No exact intersection tests are carried out against the \a targetArea.
+ */
+void AlertTarget::visitTargetPolygons(const Envelope& targetArea, const PolygonVisitor& visitor) const
+{
+  if (const GeometryQuadtree* index = quadtree())
+  {
+    index->visitPolygonCandidates(targetArea, visitor);
+    return;
+  }
+
+  visitTargetGeometries(targetArea, [&visitor](const Geometry& targetWgs84)
+  {
+    const std::shared_ptr<const PreparedPolygon> prepared = PreparedPolygon::create(targetWgs84);
+    return !prepared || visitor(prepared);
+  });
+}
+
+/*!
+  \brief Returns the distance, in meters, from \a location to the nearest target geometry.
+
+  Only geometry within \a maxDistance meters is considered: if there is none, \c -1 is returned.
+  Distances are calculated using \l GeodesicUtils. Points, multipoints and polylines are measured
+  in a \l GeodesicUtils::LocalFrame at the location if its error is within \a localFrameTolerance.
+
+  If the target has a \l quadtree, it is searched for the nearest geometry. Otherwise the target
+  geometries within an area covering \a maxDistance are visited.
+ */
+double AlertTarget::nearestTargetDistance(const Point& location, double maxDistance, double localFrameTolerance) const
+{
+  if (const GeometryQuadtree* index = quadtree())
+  {
+    const QList<GeometryQuadtree::Neighbour> nearest = index->nearestNeighbours(location, 1, maxDistance, localFrameTolerance);
+    return nearest.isEmpty() ? -1.0 : nearest.first().distance;
+  }
+
+  const Point wgs84 = ProjectionUtils::toWgs84(location);
+  if (wgs84.isEmpty())
+    return -1.0;
+
+  double xMin = 0.0;
+  double yMin = 0.0;
+  double xMax = 0.0;
+  double yMax = 0.0;
+  GeodesicUtils::boundsForDistance(wgs84.x(), wgs84.y(), maxDistance, xMin, yMin, xMax, yMax);
+  const Envelope searchArea(xMin, yMin, xMax, yMax, SpatialReference::wgs84());
+
+  const GeodesicUtils::LocalFrame frame(wgs84.x(), wgs84.y(), maxDistance);
+  const bool useFrame = frame.isWithinTolerance(localFrameTolerance);
+
+  double nearest = -1.0;
+  GeodesicUtils::PackedGeometry packed;
+  visitTargetGeometries(searchArea, [&wgs84, &nearest, &frame, &packed, useFrame, maxDistance](const Geometry& targetWgs84)
+  {
+    const double distance = (useFrame && GeodesicUtils::pack(targetWgs84, packed)) ? frame.distanceToPacked(packed)
+                                                                                 : GeodesicUtils::distanceToGeometry(wgs84, targetWgs84);
+    if (distance >= 0.0 && distance <= maxDistance && (nearest < 0.0 || distance < nearest))
+      nearest = distance;
+
+    // no target can be nearer than one at the location
+    return nearest != 0.0;
+  });
+
+  return nearest;
+}
+
+/*!
+  \brief Returns the \l GeometryQuadtree indexing the geometry of the target, or \c nullptr if it has none.
+
+  Types made up of many geometries (e.g. a layer or an overlay) should index them and return the
+  index here. The target geometry is then visited, and searched for the nearest geometry, using the
+  WGS84 geometry cached by the index rather than projecting it for every query. Changes to a single
+  geometry only update that geometry in the index, and once the geometry has not changed for
+  \c s_staticIndexDelay milliseconds the index is queried using a packed R-tree (see
+  \l GeometryQuadtree::setStaticIndexDelay).
+
+  The default implementation returns \c nullptr.
+ */
+GeometryQuadtree* AlertTarget::quadtree() const
+{
+  return nullptr;
+}
+
 } // Dsa
 
 // Signal Documentation
@@ -56,7 +189,21 @@ AlertTarget::~AlertTarget()
  */
 
 /*!
-  \fn void AlertTarget::dataChanged();
+  \fn void AlertTarget::dataChanged(Dsa::AlertChanges changes);
   \brief Signal emitted when alert target's data changes.
+
+  The kinds of change are given by \a changes: \c AlertChange::Attributes indicates a change
+  to the \l targetValue.
+
+  \sa geometryChangedInAreas
+ */
+
+/*!
+  \fn void AlertTarget::geometryChangedInAreas(const QVector<Esri::ArcGISRuntime::Envelope>& wgs84Areas);
+  \brief Signal emitted when the geometry of the target changes only within \a wgs84Areas.
+
+  Targets made up of many geometries (e.g. an overlay) can emit this, rather than \l dataChanged,
+  when some of them change. The areas cover each changed geometry both before and after the change,
+  so a condition only needs to re-evaluate the sources near to them.
  */
 
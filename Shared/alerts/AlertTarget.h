@@ -17,21 +17,35 @@
 #ifndef ALERTTARGET_H
 #define ALERTTARGET_H
 
+// dsa app headers
+#include "AlertChange.h"
+
+// C++ API headers
+#include "Envelope.h"
+
 // Qt headers
 #include <QObject>
 #include <QVariant>
+#include <QVector>
+
+// STL headers
+#include <functional>
+#include <memory>
 
 namespace Esri
 {
 namespace ArcGISRuntime
 {
-  class Envelope;
   class Geometry;
+  class Point;
 }
 }
 
 namespace Dsa {
 
+class GeometryQuadtree;
+class PreparedPolygon;
+
 class AlertTarget : public QObject
 {
   Q_OBJECT
@@ -40,12 +54,25 @@ public:
   explicit AlertTarget(QObject* parent = nullptr);
   ~AlertTarget();
 
+  using GeometryVisitor = std::function<bool(const Esri::ArcGISRuntime::Geometry& wgs84Geometry)>;
+  using PolygonVisitor = std::function<bool(const std::shared_ptr<const PreparedPolygon>& wgs84Polygon)>;
+
   virtual QList<Esri::ArcGISRuntime::Geometry> targetGeometries(const Esri::ArcGISRuntime::Envelope& targetArea) const = 0;
+  virtual void visitTargetGeometries(const Esri::ArcGISRuntime::Envelope& targetArea, const GeometryVisitor& visitor) const;
+  virtual void visitTargetPolygons(const Esri::ArcGISRuntime::Envelope& targetArea, const PolygonVisitor& visitor) const;
+  virtual double nearestTargetDistance(const Esri::ArcGISRuntime::Point& location, double maxDistance, double localFrameTolerance = -1.0) const;
   virtual QVariant targetValue() const = 0;
 
+protected:
+  virtual GeometryQuadtree* quadtree() const;
+
+  // how long, in milliseconds, the indexed geometry must be unchanged before it is queried using a packed R-tree
+  static constexpr int s_staticIndexDelay = 5000;
+
 signals:
   void noLongerValid();
-  void dataChanged();
+  void dataChanged(Dsa::AlertChanges changes);
+  void geometryChangedInAreas(const QVector<Esri::ArcGISRuntime::Envelope>& wgs84Areas);
 };
 
 } // Dsa
@@ -20,7 +20,10 @@
 #include "AttributeEqualsAlertCondition.h"
 
 // dsa app headers
+#include "AlertConditionData.h"
 #include "AlertConstants.h"
+#include "AlertSource.h"
+#include "AlertTarget.h"
 #include "AttributeEqualsAlertConditionData.h"
 
 using namespace Esri::ArcGISRuntime;
@@ -34,6 +37,13 @@ namespace Dsa {
   \brief Represents an attribute condition which will be coninuosly monitored and will
   trigger an alert when a source object's attribute matches the target value.
 
+  By default the attribute must equal the target value. Other operators (such as a numeric range or
+  a set of values) can be given when the condition is created: see \l AttributePredicate.
+
+  The attribute is resolved to a slot of \l AlertSource, and the target value is compiled into an
+  \l AttributePredicate, when they are first needed. Testing a source therefore involves no lookup of
+  the attribute by name and no conversion of the attribute or target values.
+
   This condition will create new \l AttributeEqualsAlertConditionData to track source and target objects.
   */
 
@@ -45,8 +55,25 @@ AttributeEqualsAlertCondition::AttributeEqualsAlertCondition(AlertLevel level,
                                                              const QString& name,
                                                              const QString& attributeName,
                                                              QObject* parent):
+  AttributeEqualsAlertCondition(level, name, attributeName, AttributePredicate::Operator::Equals, parent)
+{
+
+}
+
+/*!
+  \brief Constructor taking an \l AlertLevel (\a level) the \a name of the condition,
+  an \a attributeName, the operator \a op used to compare the attribute with the target value,
+  and an optional \a parent.
+ */
+AttributeEqualsAlertCondition::AttributeEqualsAlertCondition(AlertLevel level,
+                                                             const QString& name,
+                                                             const QString& attributeName,
+                                                             AttributePredicate::Operator op,
+                                                             QObject* parent):
   AlertCondition(level, name, parent),
-  m_attributeName(attributeName)
+  m_attributeName(attributeName),
+  m_operator(op),
+  m_attributeSlot(AlertSource::attributeSlot(attributeName))
 {
 
 }
@@ -64,14 +91,93 @@ AttributeEqualsAlertCondition::~AttributeEqualsAlertCondition()
  */
 AlertConditionData* AttributeEqualsAlertCondition::createData(AlertSource* source, AlertTarget* target)
 {
-  return new AttributeEqualsAlertConditionData(newConditionDataName(), level(), source, target, m_attributeName, this);
+  return new AttributeEqualsAlertConditionData(newConditionDataName(source), level(), source, target, m_attributeName, this);
+}
+
+/*!
+  \brief Returns an evaluation of whether the attribute of each of the \a sources matches the
+  value of the \a target.
+
+  The attribute values are captured when the evaluation is created.
+ */
+AlertCondition::Evaluation AttributeEqualsAlertCondition::createEvaluation(AlertTarget* target, const QList<AlertSource*>& sources) const
+{
+  QVector<AttributeValue> sourceValues;
+  sourceValues.reserve(sources.size());
+  for (AlertSource* source : sources)
+    sourceValues.append(source->attributeSlotValue(m_attributeSlot));
+
+  const AttributePredicate targetPredicate = predicate(target);
+
+  return [sourceValues, targetPredicate](EvaluationResults& results)
+  {
+    results.matches.fill(false, sourceValues.size());
+    if (!targetPredicate.isValid())
+      return;
+
+    for (int i = 0; i < sourceValues.size(); ++i)
+      results.matches[i] = targetPredicate.matches(sourceValues.at(i));
+  };
+}
+
+/*!
+  \brief Returns whether the attribute of \a source currently matches the value of \a target.
+ */
+bool AttributeEqualsAlertCondition::matches(AlertSource* source, AlertTarget* target) const
+{
+  if (!source)
+    return false;
+
+  return predicate(target).matches(source->attributeSlotValue(m_attributeSlot));
+}
+
+/*!
+  \brief Returns the operator used to compare the attribute with the target value.
+ */
+AttributePredicate::Operator AttributeEqualsAlertCondition::op() const
+{
+  return m_operator;
+}
+
+/*!
+  \brief Returns \c AlertChange::Attributes: the query is not affected by movement of the source or target.
+ */
+AlertChanges AttributeEqualsAlertCondition::dependencies() const
+{
+  return AlertChange::Attributes;
+}
+
+/*!
+  \brief Returns the name of the attribute to be tested.
+
+  Changes to other attributes of the source do not affect the query.
+ */
+QStringList AttributeEqualsAlertCondition::attributeDependencies() const
+{
+  return QStringList{m_attributeName};
 }
 
 /*!
   \brief Returns the query string component for this condition in the form "[MyAttribute] =".
+
+  Operators other than \c Equals use their own form, for example "[MyAttribute] in range".
  */
 QString AttributeEqualsAlertCondition::queryString() const
 {
+  switch (m_operator)
+  {
+  case AttributePredicate::Operator::Equals:
+    break;
+  case AttributePredicate::Operator::NotEquals:
+    return QString("[%1] != ").arg(m_attributeName);
+  case AttributePredicate::Operator::InRange:
+    return QString("[%1] in range ").arg(m_attributeName);
+  case AttributePredicate::Operator::InSet:
+    return QString("[%1] in ").arg(m_attributeName);
+  case AttributePredicate::Operator::StartsWith:
+    return QString("[%1] starts with ").arg(m_attributeName);
+  }
+
   return QString("[%1] = ").arg(m_attributeName);
 }
 
@@ -82,12 +188,15 @@ QString AttributeEqualsAlertCondition::queryString() const
 
   \list
     \li attribute_name. The name of the attribute field to be queried.
+    \li attribute_operator. The name of the operator used to compare the attribute with the target
+      value (e.g. "equals"). Conditions saved without an operator use "equals".
   \endlist
  */
 QVariantMap AttributeEqualsAlertCondition::queryComponents() const
 {
   QVariantMap queryMap;
   queryMap.insert(AlertConstants::ATTRIBUTE_NAME, m_attributeName);
+  queryMap.insert(AlertConstants::ATTRIBUTE_OPERATOR, AttributePredicate::operatorName(m_operator));
 
   return queryMap;
 }
@@ -100,4 +209,43 @@ QString AttributeEqualsAlertCondition::attributeNameFromQueryComponents(const QV
   return queryMap.value(AlertConstants::ATTRIBUTE_NAME).toString();
 }
 
+/*!
+  \brief Static method to extract the attribute operator from a \a queryMap.
+
+  Returns \c AttributePredicate::Operator::Equals if the map has no operator.
+ */
+AttributePredicate::Operator AttributeEqualsAlertCondition::operatorFromQueryComponents(const QVariantMap& queryMap)
+{
+  return AttributePredicate::operatorFromName(queryMap.value(AlertConstants::ATTRIBUTE_OPERATOR).toString());
+}
+
+/*!
+  \brief Discards the compiled predicate when the \a changes to the target include its attributes,
+  which is how a change to the target value is reported.
+ */
+void AttributeEqualsAlertCondition::invalidateTargetCaches(AlertChanges changes)
+{
+  if (changes.testFlag(AlertChange::Attributes))
+    m_predicateCompiled = false;
+}
+
+/*!
+  \brief internal
+
+  Returns the predicate for the value of \a target. It is compiled once, and again only after the
+  target reports a change to its value. A predicate which is not valid (for example, for a range
+  which is not numeric) is kept too, so it is not compiled again for each source.
+ */
+const AttributePredicate& AttributeEqualsAlertCondition::predicate(AlertTarget* target) const
+{
+  if (!m_predicateCompiled || target != m_predicateTarget)
+  {
+    m_predicate = AttributePredicate::compile(m_operator, target ? target->targetValue() : QVariant());
+    m_predicateTarget = target;
+    m_predicateCompiled = true;
+  }
+
+  return m_predicate;
+}
+
 } // Dsa
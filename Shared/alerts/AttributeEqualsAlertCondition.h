@@ -19,6 +19,7 @@
 
 // dsa app headers
 #include "AlertCondition.h"
+#include "AttributePredicate.h"
 
 // Qt headers
 #include <QObject>
@@ -35,6 +36,12 @@ public:
                                 const QString& attributeName,
                                 QObject* parent = nullptr);
 
+  AttributeEqualsAlertCondition(AlertLevel level,
+                                const QString& name,
+                                const QString& attributeName,
+                                AttributePredicate::Operator op,
+                                QObject* parent = nullptr);
+
   ~AttributeEqualsAlertCondition();
 
   AlertConditionData* createData(AlertSource* source, AlertTarget* target) override;
@@ -42,10 +49,28 @@ public:
   QString queryString() const override;
   QVariantMap queryComponents() const override;
 
+  AlertChanges dependencies() const override;
+  QStringList attributeDependencies() const override;
+
+  AttributePredicate::Operator op() const;
+  bool matches(AlertSource* source, AlertTarget* target) const;
+
   static QString attributeNameFromQueryComponents(const QVariantMap& queryMap);
+  static AttributePredicate::Operator operatorFromQueryComponents(const QVariantMap& queryMap);
+
+protected:
+  Evaluation createEvaluation(AlertTarget* target, const QList<AlertSource*>& sources) const override;
+  void invalidateTargetCaches(AlertChanges changes) override;
 
 private:
+  const AttributePredicate& predicate(AlertTarget* target) const;
+
   QString m_attributeName;
+  AttributePredicate::Operator m_operator = AttributePredicate::Operator::Equals;
+  int m_attributeSlot = -1;
+  mutable AttributePredicate m_predicate; // compiled from the value of m_predicateTarget, even if it is not valid
+  mutable const AlertTarget* m_predicateTarget = nullptr;
+  mutable bool m_predicateCompiled = false;
 };
 
 } // Dsa
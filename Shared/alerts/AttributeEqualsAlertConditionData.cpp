@@ -22,6 +22,7 @@
 // dsa app headers
 #include "AlertSource.h"
 #include "AlertTarget.h"
+#include "AttributeEqualsAlertCondition.h"
 
 using namespace Esri::ArcGISRuntime;
 
@@ -81,15 +82,12 @@ bool AttributeEqualsAlertConditionData::matchesQuery() const
   if (!isQueryOutOfDate())
     return cachedQueryResult();
 
-  const QVariant sourceValue = source()->value(attributeName());
-  if (sourceValue.isNull() || !sourceValue.isValid())
+  // the condition owns the compiled predicate and the resolved attribute slot
+  const AttributeEqualsAlertCondition* condition = qobject_cast<AttributeEqualsAlertCondition*>(parent());
+  if (!condition)
     return false;
 
-  const QVariant targetValue = target()->targetValue();
-  if (targetValue.isNull() || !targetValue.isValid())
-    return false;
-
-  return sourceValue == targetValue;
+  return condition->matches(source(), target());
 }
 
 /*!
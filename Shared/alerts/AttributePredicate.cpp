@@ -0,0 +1,319 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "AttributePredicate.h"
+
+// STL headers
+#include <algorithm>
+#include <limits>
+
+namespace Dsa {
+
+namespace
+{
+bool isNumericType(const QVariant& value)
+{
+  switch (static_cast<QMetaType::Type>(value.userType()))
+  {
+  case QMetaType::Bool:
+  case QMetaType::Int:
+  case QMetaType::UInt:
+  case QMetaType::LongLong:
+  case QMetaType::ULongLong:
+  case QMetaType::Double:
+  case QMetaType::Float:
+  case QMetaType::Long:
+  case QMetaType::ULong:
+  case QMetaType::Short:
+  case QMetaType::UShort:
+    return true;
+  default:
+    return false;
+  }
+}
+}
+
+/*!
+  \struct Dsa::AttributeValue
+  \inmodule Dsa
+  \brief An attribute value, converted once into the forms compared by an \l AttributePredicate.
+
+  Numeric values, and strings which parse as numbers, have a \c number. Every value which is not
+  null has a \c string.
+ */
+
+/*!
+  \brief Returns the typed form of \a value.
+ */
+AttributeValue AttributeValue::fromVariant(const QVariant& value)
+{
+  AttributeValue typed;
+  if (!value.isValid() || value.isNull())
+    return typed;
+
+  typed.isNull = false;
+  typed.string = value.toString();
+
+  if (isNumericType(value))
+  {
+    typed.isNumber = true;
+    typed.number = value.toDouble();
+  }
+  else if (value.userType() == QMetaType::QString)
+  {
+    typed.number = typed.string.toDouble(&typed.isNumber);
+  }
+
+  return typed;
+}
+
+/*!
+  \class Dsa::AttributePredicate
+  \inmodule Dsa
+  \brief A test of an attribute value, compiled once from an operator and an operand.
+
+  The operand is converted when the predicate is compiled, and the value being tested is an
+  \l AttributeValue which has already been converted. Testing a value therefore makes no
+  QVariant conversions and looks nothing up by name.
+
+  The supported operators are:
+
+  \list
+    \li \c Equals. The value equals the operand. If the operand is a number (or a string which parses
+      as one) values are compared as numbers, otherwise as strings.
+    \li \c NotEquals. The value is not null and does not equal the operand.
+    \li \c InRange. The value is a number between the two numbers of the operand list, inclusive.
+      Either bound can be null, for a range with no minimum or no maximum.
+    \li \c InSet. The value equals one of the operand list. If every element of the list is a number
+      values are compared as numbers, otherwise as strings.
+    \li \c StartsWith. The value, as a string, starts with the operand.
+  \endlist
+
+  A null value never matches.
+ */
+
+/*!
+  \brief Returns a predicate testing values with \a op against the \a operand.
+
+  The returned predicate is not valid if the \a operand is not suitable for the operator.
+ */
+AttributePredicate AttributePredicate::compile(Operator op, const QVariant& operand)
+{
+  AttributePredicate predicate;
+  predicate.m_operator = op;
+
+  switch (op)
+  {
+  case Operator::Equals:
+  case Operator::NotEquals:
+  {
+    const AttributeValue value = AttributeValue::fromVariant(operand);
+    if (value.isNull)
+      break;
+
+    predicate.m_kind = value.isNumber ? Kind::Number : Kind::String;
+    predicate.m_number = value.number;
+    predicate.m_string = value.string;
+    break;
+  }
+  case Operator::InRange:
+  {
+    const QVariantList bounds = operand.toList();
+    if (bounds.size() != 2)
+      break;
+
+    const AttributeValue min = AttributeValue::fromVariant(bounds.at(0));
+    const AttributeValue max = AttributeValue::fromVariant(bounds.at(1));
+    if ((!min.isNull && !min.isNumber) || (!max.isNull && !max.isNumber) || (min.isNull && max.isNull))
+      break;
+
+    predicate.m_kind = Kind::Number;
+    predicate.m_min = min.isNull ? -std::numeric_limits<double>::infinity() : min.number;
+    predicate.m_max = max.isNull ? std::numeric_limits<double>::infinity() : max.number;
+    break;
+  }
+  case Operator::InSet:
+  {
+    const QVariantList elements = operand.toList();
+    bool allNumbers = true;
+    for (const QVariant& element : elements)
+    {
+      const AttributeValue value = AttributeValue::fromVariant(element);
+      if (value.isNull)
+        continue;
+
+      allNumbers = allNumbers && value.isNumber;
+      predicate.m_numbers.append(value.number);
+      predicate.m_strings.append(value.string);
+    }
+
+    if (predicate.m_strings.isEmpty())
+      break;
+
+    predicate.m_kind = allNumbers ? Kind::Number : Kind::String;
+    std::sort(predicate.m_numbers.begin(), predicate.m_numbers.end());
+    std::sort(predicate.m_strings.begin(), predicate.m_strings.end());
+    break;
+  }
+  case Operator::StartsWith:
+  {
+    const AttributeValue value = AttributeValue::fromVariant(operand);
+    if (value.isNull || value.string.isEmpty())
+      break;
+
+    predicate.m_kind = Kind::String;
+    predicate.m_string = value.string;
+    break;
+  }
+  }
+
+  return predicate;
+}
+
+/*!
+  \brief Returns the operand for \a op written as \a text (e.g. by a user).
+
+  For \c InRange the text is the minimum and maximum separated by a comma, either of which can be
+  empty (e.g. "10, 20" or ", 20"). For \c InSet it is the elements separated by commas. For the other
+  operators it is the operand itself.
+ */
+QVariant AttributePredicate::parseOperand(Operator op, const QString& text)
+{
+  if (op != Operator::InRange && op != Operator::InSet)
+    return text;
+
+  QVariantList elements;
+  const QStringList parts = text.split(',');
+  for (const QString& part : parts)
+  {
+    const QString trimmed = part.trimmed();
+    if (op == Operator::InSet && trimmed.isEmpty())
+      continue;
+
+    elements.append(trimmed.isEmpty() ? QVariant() : QVariant(trimmed));
+  }
+
+  return elements;
+}
+
+/*!
+  \brief Returns the name of \a op, as used when conditions are saved.
+ */
+QString AttributePredicate::operatorName(Operator op)
+{
+  switch (op)
+  {
+  case Operator::Equals:
+    return QStringLiteral("equals");
+  case Operator::NotEquals:
+    return QStringLiteral("not_equals");
+  case Operator::InRange:
+    return QStringLiteral("in_range");
+  case Operator::InSet:
+    return QStringLiteral("in_set");
+  case Operator::StartsWith:
+    return QStringLiteral("starts_with");
+  }
+
+  return QString();
+}
+
+/*!
+  \brief Returns the operator with \a name.
+
+  If \a ok is supplied, it is set to whether the name was recognized. An unrecognized name
+  returns \c Equals.
+ */
+AttributePredicate::Operator AttributePredicate::operatorFromName(const QString& name, bool* ok)
+{
+  for (Operator op : {Operator::Equals, Operator::NotEquals, Operator::InRange, Operator::InSet, Operator::StartsWith})
+  {
+    if (operatorName(op) != name)
+      continue;
+
+    if (ok)
+      *ok = true;
+
+    return op;
+  }
+
+  if (ok)
+    *ok = false;
+
+  return Operator::Equals;
+}
+
+/*!
+  \brief Returns the operator of this predicate.
+ */
+AttributePredicate::Operator AttributePredicate::op() const
+{
+  return m_operator;
+}
+
+/*!
+  \brief Returns whether this predicate was compiled from a suitable operand.
+
+  An invalid predicate never matches.
+ */
+bool AttributePredicate::isValid() const
+{
+  return m_kind != Kind::Invalid;
+}
+
+/*!
+  \brief Returns whether \a value satisfies this predicate.
+ */
+bool AttributePredicate::matches(const AttributeValue& value) const
+{
+  if (value.isNull || m_kind == Kind::Invalid)
+    return false;
+
+  switch (m_operator)
+  {
+  case Operator::Equals:
+    return equals(value);
+  case Operator::NotEquals:
+    return !equals(value);
+  case Operator::InRange:
+    return value.isNumber && value.number >= m_min && value.number <= m_max;
+  case Operator::InSet:
+    if (m_kind == Kind::Number)
+      return value.isNumber && std::binary_search(m_numbers.cbegin(), m_numbers.cend(), value.number);
+
+    return std::binary_search(m_strings.cbegin(), m_strings.cend(), value.string);
+  case Operator::StartsWith:
+    return value.string.startsWith(m_string);
+  }
+
+  return false;
+}
+
+/*!
+  \brief internal
+ */
+bool AttributePredicate::equals(const AttributeValue& value) const
+{
+  if (m_kind == Kind::Number)
+    return value.isNumber && value.number == m_number;
+
+  return value.string == m_string;
+}
+
+} // Dsa
@@ -0,0 +1,86 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ATTRIBUTEPREDICATE_H
+#define ATTRIBUTEPREDICATE_H
+
+// Qt headers
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+namespace Dsa {
+
+// an attribute value, converted once into the forms which predicates compare
+struct AttributeValue
+{
+  bool isNull = true;
+  bool isNumber = false; // whether the value is numeric, or a string which parses as a number
+  double number = 0.0;
+  QString string;
+
+  static AttributeValue fromVariant(const QVariant& value);
+};
+
+class AttributePredicate
+{
+public:
+  enum class Operator
+  {
+    Equals = 0,
+    NotEquals = 1,
+    InRange = 2,
+    InSet = 3,
+    StartsWith = 4
+  };
+
+  AttributePredicate() = default;
+
+  static AttributePredicate compile(Operator op, const QVariant& operand);
+  static QVariant parseOperand(Operator op, const QString& text);
+
+  static QString operatorName(Operator op);
+  static Operator operatorFromName(const QString& name, bool* ok = nullptr);
+
+  Operator op() const;
+  bool isValid() const;
+  bool matches(const AttributeValue& value) const;
+
+private:
+  // how values are compared
+  enum class Kind
+  {
+    Invalid,
+    Number,
+    String
+  };
+
+  bool equals(const AttributeValue& value) const;
+
+  Operator m_operator = Operator::Equals;
+  Kind m_kind = Kind::Invalid;
+  double m_number = 0.0;
+  double m_min = 0.0;
+  double m_max = 0.0;
+  QString m_string;
+  QVector<double> m_numbers; // sorted
+  QStringList m_strings; // sorted
+};
+
+} // Dsa
+
+#endif // ATTRIBUTEPREDICATE_H
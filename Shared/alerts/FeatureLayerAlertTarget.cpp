@@ -24,7 +24,13 @@
 #include "GeometryQuadtree.h"
 
 // C++ API headers
+#include "ArcGISFeatureTable.h"
+#include "AttributeListModel.h"
 #include "FeatureLayer.h"
+#include "FeatureQueryResult.h"
+#include "Field.h"
+#include "OrderBy.h"
+#include "QueryParameters.h"
 
 using namespace Esri::ArcGISRuntime;
 
@@ -37,8 +43,11 @@ namespace Dsa {
   \brief Represents a target based on an \l Esri::ArcGISRuntime::FeatureLayer
   for an \l AlertCondition.
 
-  Changes to any of the features in the layer will cause the \l AlertTarget::locationChanged
+  Changes to any of the features in the layer will cause the \l AlertTarget::dataChanged
   signal to be emitted.
+
+  The features are loaded in pages, ordered by object ID, and each page is added to the
+  spatial index (see \l AlertTarget::quadtree) as it arrives.
   */
 
 /*!
@@ -53,12 +62,10 @@ FeatureLayerAlertTarget::FeatureLayerAlertTarget(FeatureLayer* featureLayer):
   // assume no editing of feature table
 
   FeatureTable* table = m_FeatureLayer->featureTable();
-  QueryParameters allFeaturesQuery;
-  allFeaturesQuery.setWhereClause("1=1");
-  allFeaturesQuery.setReturnGeometry(true);
+  m_objectIdField = objectIdFieldName(table);
 
   connect(table, &FeatureTable::queryFeaturesCompleted, this, &FeatureLayerAlertTarget::handleQueryFeaturesCompleted);
-  table->queryFeatures(allFeaturesQuery);
+  queryNextPage();
 }
 
 /*!
@@ -107,64 +114,157 @@ QVariant FeatureLayerAlertTarget::targetValue() const
   return QVariant();
 }
 
+/*!
+  \brief Returns the quadtree of the loaded features, which is built when the first page arrives.
+ */
+GeometryQuadtree* FeatureLayerAlertTarget::quadtree() const
+{
+  return m_quadtree;
+}
+
 /*!
   \brief internal.
 
-  Handle the query to obtain all of the features in the layer.
+  Handle a page of the query to obtain all of the features in the layer.
  */
-void FeatureLayerAlertTarget::handleQueryFeaturesCompleted(QUuid, FeatureQueryResult* queryResults)
+void FeatureLayerAlertTarget::handleQueryFeaturesCompleted(QUuid taskId, FeatureQueryResult* queryResults)
 {
+  // the table may also be queried by others
+  if (taskId != m_queryTaskId)
+    return;
+
+  m_queryTaskId = QUuid();
+
   // Store the results in a RAII manager to ensure they are cleaned up
   FeatureQueryResultManager results(queryResults);
   if (!results.m_results)
   {
-    emit dataChanged();
+    emit dataChanged(AlertChange::Validity);
     return;
   }
 
-  // cache all of the features
-  m_geomCache.clear();
-  m_features = results.m_results->iterator().features(this);
-  auto it = m_features.begin();
-  auto itEnd = m_features.end();
-  for (; it != itEnd; ++it)
+  const QList<Feature*> page = results.m_results->iterator().features(this);
+  addFeatures(page);
+
+  // services may return fewer features than were requested (their maximum record count), so
+  // paging only stops once a page is empty or does not advance the object ID
+  if (!m_objectIdField.isEmpty() && !page.isEmpty())
+  {
+    const qint64 previousObjectId = m_lastObjectId;
+    for (Feature* feature : page)
+    {
+      if (!feature || !feature->attributes())
+        continue;
+
+      bool ok = false;
+      const qint64 objectId = feature->attributes()->attributeValue(m_objectIdField).toLongLong(&ok);
+      if (ok && objectId > m_lastObjectId)
+        m_lastObjectId = objectId;
+    }
+
+    if (m_lastObjectId > previousObjectId)
+      queryNextPage();
+  }
+
+  emit dataChanged(AlertChange::Geometry);
+}
+
+/*!
+  \brief internal.
+
+  Queries the next page of features, following the last object ID which has been loaded.
+
+  If the table does not have an object ID field, all of the features are queried at once.
+ */
+void FeatureLayerAlertTarget::queryNextPage()
+{
+  FeatureTable* table = m_FeatureLayer->featureTable();
+  if (!table)
+    return;
+
+  QueryParameters query;
+  query.setReturnGeometry(true);
+
+  if (m_objectIdField.isEmpty())
+  {
+    query.setWhereClause("1=1");
+  }
+  else
+  {
+    query.setWhereClause(QString("%1 > %2").arg(m_objectIdField, QString::number(m_lastObjectId)));
+    query.setOrderByFields(QList<OrderBy>{OrderBy(m_objectIdField, SortOrder::Ascending)});
+    query.setMaxFeatures(s_pageSize);
+  }
+
+  m_queryTaskId = table->queryFeatures(query).taskId();
+}
+
+/*!
+  \brief internal.
+
+  Adds the \a features to the quadtree, building it for the first page.
+
+  The quadtree tracks changes to the geometry of each feature, so a change only
+  re-indexes that feature.
+ */
+void FeatureLayerAlertTarget::addFeatures(const QList<Feature*>& features)
+{
+  QList<GeoElement*> elements;
+  elements.reserve(features.size());
+  for (Feature* feature : features)
   {
-    Feature* feature = *it;
     if (!feature)
       continue;
 
+    m_features.append(feature);
+    elements.append(feature);
+
     // for each feature, connect to the geometryChanged signal
     connect(feature, &Feature::geometryChanged, this, [this]()
     {
       m_geomCache.clear();
-      rebuildQuadtree();
-      emit dataChanged();
+      emit dataChanged(AlertChange::Geometry);
     });
   }
 
-  rebuildQuadtree();
-  emit dataChanged();
+  if (elements.isEmpty())
+    return;
+
+  m_geomCache.clear();
+
+  if (m_quadtree)
+  {
+    m_quadtree->appendGeoElements(elements);
+    return;
+  }
+
+  // geofence layers rarely change, so once they settle they are queried using a packed R-tree
+  m_quadtree = new GeometryQuadtree(m_FeatureLayer->fullExtent(), elements, 8, this);
+  m_quadtree->setStaticIndexDelay(s_staticIndexDelay);
 }
 
 /*!
   \brief internal.
 
-  Build the quadtree used to find intersections with feature geometry etc.
+  Returns the name of the object ID field of \a featureTable, or an empty string if it has none.
  */
-void FeatureLayerAlertTarget::rebuildQuadtree()
+QString FeatureLayerAlertTarget::objectIdFieldName(FeatureTable* featureTable)
 {
-  if (m_quadtree)
+  if (!featureTable)
+    return QString();
+
+  ArcGISFeatureTable* agsFeatureTable = qobject_cast<ArcGISFeatureTable*>(featureTable);
+  if (agsFeatureTable)
+    return agsFeatureTable->objectIdField();
+
+  const QList<Field> fields = featureTable->fields();
+  for (const Field& field : fields)
   {
-    delete m_quadtree;
-    m_quadtree = nullptr;
+    if (field.fieldType() == FieldType::OID)
+      return field.name();
   }
 
-  QList<GeoElement*> elements;
-  for (auto it = m_features.begin(); it != m_features.end(); ++it)
-    elements.append(*it);
-
-  if (elements.size() > 1)
-    m_quadtree = new GeometryQuadtree(m_FeatureLayer->fullExtent(), elements, 8, this);
+  return QString();
 }
 
 } // Dsa
@@ -28,6 +28,7 @@ namespace ArcGISRuntime {
 class Feature;
 class FeatureLayer;
 class FeatureQueryResult;
+class FeatureTable;
 }
 }
 
@@ -46,16 +47,28 @@ public:
   QList<Esri::ArcGISRuntime::Geometry> targetGeometries(const Esri::ArcGISRuntime::Envelope& targetArea) const override;
   QVariant targetValue() const override;
 
+protected:
+  GeometryQuadtree* quadtree() const override;
+
 private slots:
   void handleQueryFeaturesCompleted(QUuid taskId, Esri::ArcGISRuntime::FeatureQueryResult* featureQueryResult);
 
 private:
-  void rebuildQuadtree();
+  void queryNextPage();
+  void addFeatures(const QList<Esri::ArcGISRuntime::Feature*>& features);
+
+  static QString objectIdFieldName(Esri::ArcGISRuntime::FeatureTable* featureTable);
+
+  // the number of features requested in each page of the initial load
+  static constexpr int s_pageSize = 1000;
 
   Esri::ArcGISRuntime::FeatureLayer* m_FeatureLayer = nullptr;
   GeometryQuadtree* m_quadtree = nullptr;
   QList<Esri::ArcGISRuntime::Feature*> m_features;
   mutable QList<Esri::ArcGISRuntime::Geometry> m_geomCache;
+  QString m_objectIdField;
+  qint64 m_lastObjectId = -1;
+  QUuid m_queryTaskId;
 };
 
 } // Dsa
@@ -0,0 +1,243 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "FeatureTargetCache.h"
+
+// dsa app headers
+#include "FeatureQueryResultManager.h"
+#include "GeoElementAlertTarget.h"
+
+// C++ API headers
+#include "AttributeListModel.h"
+#include "Feature.h"
+#include "FeatureQueryResult.h"
+#include "FeatureTable.h"
+#include "QueryParameters.h"
+
+// Qt headers
+#include <QTimer>
+
+// STL headers
+#include <algorithm>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+/*!
+  \class Dsa::FeatureTargetCache
+  \inmodule Dsa
+  \inherits QObject
+  \brief A cache of the \l GeoElementAlertTarget for each feature in an
+  \l Esri::ArcGISRuntime::FeatureTable, keyed by primary key.
+
+  A target is returned immediately for any key. The features for all of the keys requested
+  during one pass of the event loop are then fetched with a single query, and each target is
+  set to its feature when the query completes. A condition using the target is evaluated
+  against the feature from then on.
+
+  The cache is a child of the table and there is one target per feature, so restoring
+  many conditions for the same table costs one query rather than one per condition.
+
+  If no feature has a requested key, the target reports \l AlertTarget::noLongerValid, so that
+  the conditions using it are removed, and is deleted. If a query fails, its keys are queried
+  again.
+  */
+
+/*!
+  \brief Constructor taking the \a featureTable and the name of its \a primaryKeyField.
+ */
+FeatureTargetCache::FeatureTargetCache(FeatureTable* featureTable, const QString& primaryKeyField):
+  QObject(featureTable),
+  m_featureTable(featureTable),
+  m_primaryKeyField(primaryKeyField)
+{
+  connect(m_featureTable, &FeatureTable::queryFeaturesCompleted, this, &FeatureTargetCache::handleQueryFeaturesCompleted);
+  connect(m_featureTable, &FeatureTable::errorOccurred, this, [this](Error)
+  {
+    // the error may come from any operation on the table: check the state of our query once it has settled
+    QTimer::singleShot(0, this, &FeatureTargetCache::handleTableError);
+  });
+}
+
+/*!
+  \brief Destructor.
+ */
+FeatureTargetCache::~FeatureTargetCache()
+{
+}
+
+/*!
+  \brief Returns the target for the feature with the \a primaryKey.
+
+  If the feature has not been fetched yet, the returned target has no geometry until the
+  query for it completes.
+ */
+GeoElementAlertTarget* FeatureTargetCache::target(qint64 primaryKey)
+{
+  auto it = m_targets.constFind(primaryKey);
+  if (it != m_targets.constEnd())
+    return it.value();
+
+  GeoElementAlertTarget* target = new GeoElementAlertTarget(nullptr, this);
+  m_targets.insert(primaryKey, target);
+  m_pendingKeys.insert(primaryKey);
+
+  // batch the keys requested in this pass of the event loop into one query
+  if (!m_queryScheduled)
+  {
+    m_queryScheduled = true;
+    QTimer::singleShot(0, this, &FeatureTargetCache::queryPendingKeys);
+  }
+
+  return target;
+}
+
+/*!
+  \brief internal
+
+  Queries the features for the pending keys, unless a query is already in progress.
+ */
+void FeatureTargetCache::queryPendingKeys()
+{
+  m_queryScheduled = false;
+
+  if (m_queryWatcher.isValid() || m_pendingKeys.isEmpty())
+    return;
+
+  QList<qint64> keys = m_pendingKeys.values();
+  std::sort(keys.begin(), keys.end());
+  if (keys.size() > s_maxKeysPerQuery)
+    keys = keys.mid(0, s_maxKeysPerQuery);
+
+  QStringList keyStrings;
+  keyStrings.reserve(keys.size());
+  for (qint64 key : keys)
+  {
+    m_pendingKeys.remove(key);
+    keyStrings.append(QString::number(key));
+  }
+
+  QueryParameters query;
+  query.setReturnGeometry(true);
+  query.setWhereClause(QString("\"%1\" IN (%2)").arg(m_primaryKeyField, keyStrings.join(',')));
+
+  m_queryKeys = keys;
+  m_queryWatcher = m_featureTable->queryFeatures(query);
+}
+
+/*!
+  \brief internal
+
+  Sets the target for each feature in the query results, then queries any keys which were
+  requested while the query was in progress. The target of each requested key which has no
+  feature is no longer valid.
+ */
+void FeatureTargetCache::handleQueryFeaturesCompleted(QUuid taskId, FeatureQueryResult* featureQueryResult)
+{
+  // the table may also be queried by others
+  if (!m_queryWatcher.isValid() || taskId != m_queryWatcher.taskId())
+    return;
+
+  const QList<qint64> queryKeys = m_queryKeys;
+  m_queryWatcher = TaskWatcher();
+  m_queryKeys.clear();
+
+  // Store the results in a RAII manager to ensure they are cleaned up
+  FeatureQueryResultManager results(featureQueryResult);
+  if (!results.m_results)
+  {
+    retryQuery(queryKeys);
+    return;
+  }
+
+  m_failedQueries = 0;
+
+  const QList<Feature*> features = results.m_results->iterator().features(this);
+  for (Feature* feature : features)
+  {
+    if (!feature || !feature->attributes())
+      continue;
+
+    bool ok = false;
+    const qint64 key = feature->attributes()->attributeValue(m_primaryKeyField).toLongLong(&ok);
+    GeoElementAlertTarget* target = ok ? m_targets.value(key, nullptr) : nullptr;
+    if (!target || target->geoElement())
+    {
+      delete feature;
+      continue;
+    }
+
+    target->setGeoElement(feature);
+  }
+
+  // the features for the remaining keys no longer exist
+  for (qint64 key : queryKeys)
+  {
+    GeoElementAlertTarget* target = m_targets.value(key, nullptr);
+    if (!target || target->geoElement())
+      continue;
+
+    m_targets.remove(key);
+    emit target->noLongerValid();
+    target->deleteLater();
+  }
+
+  queryPendingKeys();
+}
+
+/*!
+  \brief internal
+
+  Handles an error reported by the table, which may have come from any operation on it. Our
+  query has only failed if it has finished without reporting its results.
+ */
+void FeatureTargetCache::handleTableError()
+{
+  if (!m_queryWatcher.isValid() || !(m_queryWatcher.isDone() || m_queryWatcher.isCanceled()))
+    return;
+
+  const QList<qint64> queryKeys = m_queryKeys;
+  m_queryWatcher = TaskWatcher();
+  m_queryKeys.clear();
+  retryQuery(queryKeys);
+}
+
+/*!
+  \brief internal
+
+  Returns the \a keys of a failed query to the pending keys and queries them again, unless the
+  queries have failed repeatedly. In that case they are queried along with the next keys to be
+  requested.
+ */
+void FeatureTargetCache::retryQuery(const QList<qint64>& keys)
+{
+  for (qint64 key : keys)
+    m_pendingKeys.insert(key);
+
+  if (++m_failedQueries < s_maxQueryAttempts)
+  {
+    queryPendingKeys();
+    return;
+  }
+
+  m_failedQueries = 0;
+}
+
+} // Dsa
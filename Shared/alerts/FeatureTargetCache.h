@@ -0,0 +1,77 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef FEATURETARGETCACHE_H
+#define FEATURETARGETCACHE_H
+
+// C++ API headers
+#include "TaskWatcher.h"
+
+// Qt headers
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QUuid>
+
+namespace Esri {
+namespace ArcGISRuntime {
+class FeatureQueryResult;
+class FeatureTable;
+}
+}
+
+namespace Dsa {
+
+class GeoElementAlertTarget;
+
+class FeatureTargetCache : public QObject
+{
+  Q_OBJECT
+
+public:
+  FeatureTargetCache(Esri::ArcGISRuntime::FeatureTable* featureTable, const QString& primaryKeyField);
+  ~FeatureTargetCache();
+
+  GeoElementAlertTarget* target(qint64 primaryKey);
+
+private slots:
+  void queryPendingKeys();
+  void handleQueryFeaturesCompleted(QUuid taskId, Esri::ArcGISRuntime::FeatureQueryResult* featureQueryResult);
+  void handleTableError();
+
+private:
+  void retryQuery(const QList<qint64>& keys);
+
+  // the maximum number of keys in the where clause of a single query
+  static constexpr int s_maxKeysPerQuery = 1000;
+
+  // the number of times in a row that a query is retried after it fails
+  static constexpr int s_maxQueryAttempts = 3;
+
+  Esri::ArcGISRuntime::FeatureTable* m_featureTable = nullptr;
+  QString m_primaryKeyField;
+  QHash<qint64, GeoElementAlertTarget*> m_targets;
+  QSet<qint64> m_pendingKeys;
+  bool m_queryScheduled = false;
+  Esri::ArcGISRuntime::TaskWatcher m_queryWatcher;
+  QList<qint64> m_queryKeys; // the keys requested by the query in progress
+  int m_failedQueries = 0;
+};
+
+} // Dsa
+
+#endif // FEATURETARGETCACHE_H
@@ -21,11 +21,12 @@
 #include "GeoElementAlertTarget.h"
 
 #include "GeoElementUtils.h"
+#include "PreparedPolygon.h"
+#include "ProjectionUtils.h"
 
 // C++ API headers
 #include "GeoElement.h"
 #include "Geometry.h"
-#include "GeometryEngine.h"
 
 using namespace Esri::ArcGISRuntime;
 
@@ -40,16 +41,30 @@ namespace Dsa {
 
   Changes to the geometry of the underlying element will cause the \l AlertTarget::locationChanged
   signal to be emitted.
+
+  The element can be set after construction (e.g. when it is the result of an asynchronous query).
+  Until then the target has no geometry.
   */
 
 /*!
   \brief Constructor taking an \l Esri::ArcGISRuntime::GeoElement (\a geoElement).
+
+  The target is a child of the \a geoElement.
  */
 GeoElementAlertTarget::GeoElementAlertTarget(GeoElement* geoElement):
-  AlertTarget(GeoElementUtils::toQObject(geoElement)),
-  m_geoElementSignaler(new GeoElementSignaler(geoElement, this))
+  GeoElementAlertTarget(geoElement, GeoElementUtils::toQObject(geoElement))
+{
+}
+
+/*!
+  \brief Constructor taking an \l Esri::ArcGISRuntime::GeoElement (\a geoElement), which may be
+  \c nullptr, and a \a parent.
+ */
+GeoElementAlertTarget::GeoElementAlertTarget(GeoElement* geoElement, QObject* parent):
+  AlertTarget(parent)
 {
-  connect(m_geoElementSignaler, &GeoElementSignaler::geometryChanged, this, &GeoElementAlertTarget::dataChanged);
+  if (geoElement)
+    setGeoElement(geoElement);
 }
 
 /*!
@@ -59,6 +74,44 @@ GeoElementAlertTarget::~GeoElementAlertTarget()
 {
 }
 
+/*!
+  \brief Returns the underlying \l Esri::ArcGISRuntime::GeoElement, or \c nullptr if it has not been set.
+ */
+GeoElement* GeoElementAlertTarget::geoElement() const
+{
+  return m_geoElementSignaler ? m_geoElementSignaler->geoElement() : nullptr;
+}
+
+/*!
+  \brief Sets the underlying \l Esri::ArcGISRuntime::GeoElement to \a geoElement.
+
+  The target does not take ownership of the \a geoElement. Conditions using the target are
+  re-evaluated against its geometry.
+ */
+void GeoElementAlertTarget::setGeoElement(GeoElement* geoElement)
+{
+  if (geoElement == this->geoElement())
+    return;
+
+  delete m_geoElementSignaler;
+  m_geoElementSignaler = nullptr;
+  m_preparedPolygon.reset();
+  m_polygonPrepared = false;
+
+  if (geoElement)
+  {
+    m_geoElementSignaler = new GeoElementSignaler(geoElement, this);
+    connect(m_geoElementSignaler, &GeoElementSignaler::geometryChanged, this, [this]()
+    {
+      m_preparedPolygon.reset();
+      m_polygonPrepared = false;
+      emit dataChanged(AlertChange::Geometry);
+    });
+  }
+
+  emit dataChanged(AlertChange::Geometry);
+}
+
 /*!
   \brief Returns the \l Esri::ArcGISRuntime::Geometry of the underlying \l \l Esri::ArcGISRuntime::GeoElement.
 
@@ -66,9 +119,33 @@ GeoElementAlertTarget::~GeoElementAlertTarget()
  */
 QList<Geometry> GeoElementAlertTarget::targetGeometries(const Envelope&) const
 {
+  if (!m_geoElementSignaler)
+    return QList<Geometry>();
+
   return QList<Geometry>{m_geoElementSignaler->geoElement()->geometry()};
 }
 
+/*!
+  \brief Calls \a visitor with a \l PreparedPolygon of the underlying element, if it is a polygon.
+
+  The polygon is prepared the first time it is visited, and again after each change to its geometry.
+ */
+void GeoElementAlertTarget::visitTargetPolygons(const Envelope&, const PolygonVisitor& visitor) const
+{
+  if (!m_geoElementSignaler)
+    return;
+
+  if (!m_polygonPrepared)
+  {
+    const Geometry geometry = m_geoElementSignaler->geoElement()->geometry();
+    m_preparedPolygon = PreparedPolygon::create(ProjectionUtils::toWgs84(geometry));
+    m_polygonPrepared = true;
+  }
+
+  if (m_preparedPolygon)
+    visitor(m_preparedPolygon);
+}
+
 /*!
   \brief Returns an empty QVariant.
  */
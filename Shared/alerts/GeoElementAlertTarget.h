@@ -35,13 +35,20 @@ class GeoElementAlertTarget : public AlertTarget
 
 public:
   explicit GeoElementAlertTarget(Esri::ArcGISRuntime::GeoElement* geoElement);
+  GeoElementAlertTarget(Esri::ArcGISRuntime::GeoElement* geoElement, QObject* parent);
   ~GeoElementAlertTarget();
 
+  Esri::ArcGISRuntime::GeoElement* geoElement() const;
+  void setGeoElement(Esri::ArcGISRuntime::GeoElement* geoElement);
+
   QList<Esri::ArcGISRuntime::Geometry> targetGeometries(const Esri::ArcGISRuntime::Envelope& targetArea) const override;
+  void visitTargetPolygons(const Esri::ArcGISRuntime::Envelope& targetArea, const PolygonVisitor& visitor) const override;
   QVariant targetValue() const override;
 
 private:
   GeoElementSignaler* m_geoElementSignaler = nullptr;
+  mutable std::shared_ptr<const PreparedPolygon> m_preparedPolygon;
+  mutable bool m_polygonPrepared = false;
 };
 
 } // Dsa
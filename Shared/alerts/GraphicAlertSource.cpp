@@ -35,8 +35,11 @@ namespace Dsa {
   \brief Represents a source based on a single \l Esri::ArcGISRuntime::Graphic
   for an \l AlertCondition.
 
-  Changes to the underlying graphic's position will cause the \l AlertSource::locationChanged
-  signal to be emitted.
+  Changes to the underlying graphic's position or attributes will cause the \l AlertSource::dataChanged
+  signal to be emitted, reporting which attributes changed.
+
+  The source is a child of the graphic. Use \l sourceFor so that a single source is shared by
+  every \l AlertCondition using the graphic.
  */
 
 /*!
@@ -46,9 +49,19 @@ GraphicAlertSource::GraphicAlertSource(Graphic* graphic):
   AlertSource(graphic),
   m_graphic(graphic)
 {
-  connect(m_graphic, &Graphic::geometryChanged, this, &GraphicAlertSource::dataChanged);
-  connect(m_graphic->attributes(), &AttributeListModel::modelReset, this, &GraphicAlertSource::dataChanged);
-  connect(m_graphic->attributes(), &AttributeListModel::dataChanged, this, &GraphicAlertSource::dataChanged);
+  connect(m_graphic, &Graphic::geometryChanged, this, [this]()
+  {
+    emit dataChanged(AlertChange::Geometry, QStringList());
+  });
+
+  // the attributes are often reset as a whole (e.g. for each new message), so changes are found by
+  // comparing against a copy of the previous values
+  if (m_graphic->attributes())
+  {
+    m_attributes = m_graphic->attributes()->attributesMap();
+    connect(m_graphic->attributes(), &AttributeListModel::modelReset, this, &GraphicAlertSource::handleAttributesChanged);
+    connect(m_graphic->attributes(), &AttributeListModel::dataChanged, this, &GraphicAlertSource::handleAttributesChanged);
+  }
 }
 
 /*!
@@ -59,6 +72,21 @@ GraphicAlertSource::~GraphicAlertSource()
 
 }
 
+/*!
+  \brief Returns the source for \a graphic, creating it if the graphic does not have one yet.
+ */
+GraphicAlertSource* GraphicAlertSource::sourceFor(Graphic* graphic)
+{
+  if (!graphic)
+    return nullptr;
+
+  GraphicAlertSource* source = graphic->findChild<GraphicAlertSource*>(QString(), Qt::FindDirectChildrenOnly);
+  if (source)
+    return source;
+
+  return new GraphicAlertSource(graphic);
+}
+
 /*!
   \brief Returns the location of the underlying \l Esri::ArcGISRuntime::Graphic.
  */
@@ -90,4 +118,37 @@ void GraphicAlertSource::setSelected(bool selected)
   m_graphic->setSelected(selected);
 }
 
+/*!
+  \internal
+
+  Compares the attributes of the \l Esri::ArcGISRuntime::Graphic with their previous values and
+  reports the keys which have changed, if any.
+ */
+void GraphicAlertSource::handleAttributesChanged()
+{
+  const QVariantMap attributes = m_graphic->attributes()->attributesMap();
+
+  QStringList changedKeys;
+  for (auto it = attributes.cbegin(); it != attributes.cend(); ++it)
+  {
+    auto findIt = m_attributes.constFind(it.key());
+    if (findIt == m_attributes.cend() || findIt.value() != it.value())
+      changedKeys.append(it.key());
+  }
+
+  // attributes which have been removed have also changed
+  for (auto it = m_attributes.cbegin(); it != m_attributes.cend(); ++it)
+  {
+    if (!attributes.contains(it.key()))
+      changedKeys.append(it.key());
+  }
+
+  m_attributes = attributes;
+
+  if (changedKeys.isEmpty())
+    return;
+
+  emit dataChanged(AlertChange::Attributes, changedKeys);
+}
+
 } // Dsa
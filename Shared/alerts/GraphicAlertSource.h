@@ -20,6 +20,9 @@
 // dsa app headers
 #include "AlertSource.h"
 
+// Qt headers
+#include <QVariantMap>
+
 namespace Esri {
 namespace ArcGISRuntime {
 class Graphic;
@@ -36,13 +39,18 @@ public:
   explicit GraphicAlertSource(Esri::ArcGISRuntime::Graphic* graphic);
   ~GraphicAlertSource();
 
+  static GraphicAlertSource* sourceFor(Esri::ArcGISRuntime::Graphic* graphic);
+
   Esri::ArcGISRuntime::Point location() const override;
   QVariant value(const QString& key) const override;
 
   void setSelected(bool selected) override;
 
 private:
+  void handleAttributesChanged();
+
   Esri::ArcGISRuntime::Graphic* m_graphic = nullptr;
+  QVariantMap m_attributes;
 };
 
 } // Dsa
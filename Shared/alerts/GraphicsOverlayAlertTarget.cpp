@@ -39,6 +39,14 @@ namespace Dsa {
 
   Changes to any of the graphics in the overlay will cause the \l AlertTarget::locationChanged
   signal to be emitted.
+
+  Graphics which are added to or removed from the overlay are added to or removed from the
+  spatial index (see \l AlertTarget::quadtree) individually. The index is only rebuilt when the
+  overlay is reset.
+
+  Once the spatial index has been built, graphics which are added, moved or removed are reported
+  with \l AlertTarget::geometryChangedInAreas, giving the areas they occupied before and after the
+  change, so that conditions only need to re-evaluate the sources near to them.
   */
 
 /*!
@@ -51,11 +59,26 @@ GraphicsOverlayAlertTarget::GraphicsOverlayAlertTarget(GraphicsOverlay* graphics
   AlertTarget(graphicsOverlay),
   m_graphicsOverlay(graphicsOverlay)
 {
-  // respond to graphics being removed from the overlay
+  // respond to graphics being removed from the overlay. The graphics are still in the
+  // model when it is about to remove them, so each one is removed from the index in place
+  connect(m_graphicsOverlay->graphics(), &GraphicListModel::rowsAboutToBeRemoved, this, [this](const QModelIndex&, int first, int last)
+  {
+    for (int i = first; i <= last; ++i)
+      removeGraphic(m_graphicsOverlay->graphics()->at(i));
+  });
+
+  // the index reports the area of a graphic which is removed from it
   connect(m_graphicsOverlay->graphics(), &GraphicListModel::itemRemoved, this, [this](int)
+  {
+    if (!m_quadtree)
+      emit dataChanged(AlertChange::Geometry);
+  });
+
+  // respond to all of the graphics being replaced
+  connect(m_graphicsOverlay->graphics(), &GraphicListModel::modelReset, this, [this]()
   {
     rebuildQuadtree();
-    emit dataChanged();
+    emit dataChanged(AlertChange::Geometry);
   });
 
   // respond to graphics being added to the overlay
@@ -64,11 +87,13 @@ GraphicsOverlayAlertTarget::GraphicsOverlayAlertTarget(GraphicsOverlay* graphics
     Graphic* graphic = m_graphicsOverlay->graphics()->at(index);
     setupGraphicConnections(graphic);
     if (m_quadtree)
+    {
       m_quadtree->appendGeoElment(graphic);
-    else
-      rebuildQuadtree();
+      return;
+    }
 
-    emit dataChanged();
+    rebuildQuadtree();
+    emit dataChanged(AlertChange::Geometry);
   });
 
   // build the quadtree for all graphics in the overlay to begin with
@@ -119,17 +144,53 @@ QVariant GraphicsOverlayAlertTarget::targetValue() const
   return QVariant();
 }
 
+/*!
+  \brief Returns the quadtree of the graphics in the overlay, or \c nullptr if there are fewer than two.
+ */
+GeometryQuadtree* GraphicsOverlayAlertTarget::quadtree() const
+{
+  return m_quadtree;
+}
+
 /*!
   \internal
 
   Connect signals etc. for a new \a graphic.
+
+  Each graphic is only connected once. Changes to graphics in the quadtree are reported by
+  the quadtree instead.
  */
 void GraphicsOverlayAlertTarget::setupGraphicConnections(Graphic* graphic)
+{
+  if (!graphic || m_graphicConnections.contains(graphic))
+    return;
+
+  m_graphicConnections.insert(graphic, connect(graphic, &Graphic::geometryChanged, this, [this]()
+  {
+    if (!m_quadtree)
+      emit dataChanged(AlertChange::Geometry);
+  }));
+}
+
+/*!
+  \internal
+
+  Disconnect from the \a graphic and remove it from the quadtree.
+ */
+void GraphicsOverlayAlertTarget::removeGraphic(Graphic* graphic)
 {
   if (!graphic)
     return;
 
-  m_graphicConnections.append(connect(graphic, &Graphic::geometryChanged, this, &GraphicsOverlayAlertTarget::dataChanged));
+  auto findIt = m_graphicConnections.find(graphic);
+  if (findIt != m_graphicConnections.end())
+  {
+    disconnect(findIt.value());
+    m_graphicConnections.erase(findIt);
+  }
+
+  if (m_quadtree)
+    m_quadtree->removeGeoElement(graphic);
 }
 
 /*!
@@ -145,6 +206,11 @@ void GraphicsOverlayAlertTarget::rebuildQuadtree()
     m_quadtree = nullptr;
   }
 
+  for (const QMetaObject::Connection& connection : qAsConst(m_graphicConnections))
+    disconnect(connection);
+
+  m_graphicConnections.clear();
+
   const GraphicListModel* graphics = m_graphicsOverlay->graphics();
   if (!graphics)
     return;
@@ -162,8 +228,22 @@ void GraphicsOverlayAlertTarget::rebuildQuadtree()
   }
 
   // if there is more than 1 element in the overlay, build a quadtree
-  if (elements.size() > 1)
-    m_quadtree = new GeometryQuadtree(m_graphicsOverlay->extent(), elements, 8, this);
+  if (elements.size() <= 1)
+    return;
+
+  m_quadtree = new GeometryQuadtree(m_graphicsOverlay->extent(), elements, 8, this);
+
+  // graphics which stop changing (e.g. fixed markup) are queried using a packed R-tree
+  m_quadtree->setStaticIndexDelay(s_staticIndexDelay);
+  connect(m_quadtree, &GeometryQuadtree::elementsChanged, this, [this](const QVector<GeometryQuadtree::Bounds>& changedBounds)
+  {
+    QVector<Envelope> areas;
+    areas.reserve(changedBounds.size());
+    for (const GeometryQuadtree::Bounds& bounds : changedBounds)
+      areas.append(Envelope(bounds.xMin, bounds.yMin, bounds.xMax, bounds.yMax, SpatialReference::wgs84()));
+
+    emit geometryChangedInAreas(areas);
+  });
 }
 
 } // Dsa
@@ -20,6 +20,9 @@
 // dsa app headers
 #include "AlertTarget.h"
 
+// Qt headers
+#include <QHash>
+
 namespace Esri {
 namespace ArcGISRuntime {
 class Graphic;
@@ -42,13 +45,17 @@ public:
   QList<Esri::ArcGISRuntime::Geometry> targetGeometries(const Esri::ArcGISRuntime::Envelope& targetArea) const override;
   QVariant targetValue() const override;
 
+protected:
+  GeometryQuadtree* quadtree() const override;
+
 private:
   void setupGraphicConnections(Esri::ArcGISRuntime::Graphic* graphic);
+  void removeGraphic(Esri::ArcGISRuntime::Graphic* graphic);
   void rebuildQuadtree();
 
   Esri::ArcGISRuntime::GraphicsOverlay* m_graphicsOverlay = nullptr;
   GeometryQuadtree* m_quadtree = nullptr;
-  QList<QMetaObject::Connection> m_graphicConnections;
+  QHash<Esri::ArcGISRuntime::Graphic*, QMetaObject::Connection> m_graphicConnections;
 };
 
 } // Dsa
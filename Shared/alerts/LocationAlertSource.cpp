@@ -52,7 +52,7 @@ LocationAlertSource::LocationAlertSource(QObject* parent):
       return;
 
     m_location = location;
-    emit dataChanged();
+    emit dataChanged(AlertChange::Geometry, QStringList());
   });
 }
 
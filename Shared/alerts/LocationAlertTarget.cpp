@@ -20,6 +20,7 @@
 #include "LocationAlertTarget.h"
 
 // toolkit headers
+#include "ProjectionUtils.h"
 #include "ToolResourceProvider.h"
 
 // C++ API headers
@@ -51,7 +52,7 @@ LocationAlertTarget::LocationAlertTarget(QObject* parent):
       return;
 
     m_location = location;
-    emit dataChanged();
+    emit dataChanged(AlertChange::Geometry);
   });
 }
 
@@ -70,7 +71,7 @@ LocationAlertTarget::~LocationAlertTarget()
  */
 QList<Geometry> LocationAlertTarget::targetGeometries(const Envelope& targetArea) const
 {
-  const Point projected = GeometryEngine::project(m_location, targetArea.spatialReference());
+  const Point projected = ProjectionUtils::project(m_location, targetArea.spatialReference());
   if (GeometryEngine::instance()->contains(targetArea, projected))
     return QList<Geometry>{m_location};
 
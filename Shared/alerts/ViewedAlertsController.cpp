@@ -42,6 +42,9 @@ namespace Dsa {
   This tool reports changes to the total number of alert condition data which are
   active but have not been marked as viwed.
 
+  The counts, in total and for each \l AlertLevel, are maintained as individual alerts
+  change, are inserted or are removed, rather than by re-scanning the \l AlertListModel.
+
   \sa AlertListModel
   \sa AlertConditionData
  */
@@ -50,15 +53,17 @@ namespace Dsa {
   \brief Constructor taking an optional \a parent.
  */
 ViewedAlertsController::ViewedAlertsController(QObject* parent /* = nullptr */):
-  AbstractTool(parent)
+  AbstractTool(parent),
+  m_levelCounts(static_cast<int>(AlertLevel::Critical) + 1, 0)
 {
   AlertListModel* model = AlertListModel::instance();
   if (model)
   {
     connect(model, &AlertListModel::dataChanged, this, &ViewedAlertsController::handleDataChanged);
-    connect(model, &AlertListModel::rowsInserted, this, &ViewedAlertsController::handleDataChanged);
-    connect(model, &AlertListModel::rowsRemoved, this, &ViewedAlertsController::handleDataChanged);
-    emit unviewedCountChanged();
+    connect(model, &AlertListModel::rowsInserted, this, &ViewedAlertsController::handleRowsInserted);
+    connect(model, &AlertListModel::rowsAboutToBeRemoved, this, &ViewedAlertsController::handleRowsAboutToBeRemoved);
+    connect(model, &AlertListModel::modelReset, this, &ViewedAlertsController::handleModelReset);
+    handleModelReset();
   }
 
   ToolManager::instance().addTool(this);
@@ -72,16 +77,6 @@ QString ViewedAlertsController::toolName() const
   return QString("viewed alerts");
 }
 
-void ViewedAlertsController::handleDataChanged()
-{
-  const int oldCount = m_cachedCount;
-  m_cachedCount = -1;
-  m_cachedCount = unviewedCount();
-
-  if (oldCount != m_cachedCount)
-    emit unviewedCountChanged();
-}
-
 /*!
   \brief Destructor.
  */
@@ -96,36 +91,185 @@ ViewedAlertsController::~ViewedAlertsController()
  */
 int ViewedAlertsController::unviewedCount() const
 {
-  if (m_cachedCount != -1)
-    return m_cachedCount;
+  return m_count;
+}
+
+/*!
+  \property ViewedAlertsController::unviewedLowCount
+  \brief Returns the number of unviewed, active alerts with the level \c AlertLevel::Low.
+ */
+int ViewedAlertsController::unviewedLowCount() const
+{
+  return unviewedCountForLevel(static_cast<int>(AlertLevel::Low));
+}
+
+/*!
+  \property ViewedAlertsController::unviewedMediumCount
+  \brief Returns the number of unviewed, active alerts with the level \c AlertLevel::Medium.
+ */
+int ViewedAlertsController::unviewedMediumCount() const
+{
+  return unviewedCountForLevel(static_cast<int>(AlertLevel::Medium));
+}
+
+/*!
+  \property ViewedAlertsController::unviewedHighCount
+  \brief Returns the number of unviewed, active alerts with the level \c AlertLevel::High.
+ */
+int ViewedAlertsController::unviewedHighCount() const
+{
+  return unviewedCountForLevel(static_cast<int>(AlertLevel::High));
+}
+
+/*!
+  \property ViewedAlertsController::unviewedCriticalCount
+  \brief Returns the number of unviewed, active alerts with the level \c AlertLevel::Critical.
+ */
+int ViewedAlertsController::unviewedCriticalCount() const
+{
+  return unviewedCountForLevel(static_cast<int>(AlertLevel::Critical));
+}
+
+/*!
+  \brief Returns the number of unviewed, active alerts with the \l AlertLevel \a level.
+ */
+int ViewedAlertsController::unviewedCountForLevel(int level) const
+{
+  if (level < 0 || level >= m_levelCounts.size())
+    return 0;
 
+  return m_levelCounts.at(level);
+}
+
+/*!
+  \internal
+
+  Updates the counts for the alerts in the rows from \a topLeft to \a bottomRight.
+ */
+void ViewedAlertsController::handleDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
   AlertListModel* model = AlertListModel::instance();
   if (!model)
-    return 0;
+    return;
+
+  bool changed = false;
+  for (int row = topLeft.row(); row <= bottomRight.row(); ++row)
+  {
+    if (updateAlert(model->alertAt(row)))
+      changed = true;
+  }
+
+  if (changed)
+    emit unviewedCountChanged();
+}
+
+/*!
+  \internal
+
+  Counts the alerts in the new rows from \a first to \a last.
+ */
+void ViewedAlertsController::handleRowsInserted(const QModelIndex&, int first, int last)
+{
+  AlertListModel* model = AlertListModel::instance();
+  if (!model)
+    return;
+
+  handleDataChanged(model->index(first, 0), model->index(last, 0));
+}
 
-  int count = 0;
-  const int alertsCount = model->rowCount();
-  for (int i = 0; i < alertsCount; ++i)
+/*!
+  \internal
+
+  Removes the alerts in the rows from \a first to \a last from the counts.
+ */
+void ViewedAlertsController::handleRowsAboutToBeRemoved(const QModelIndex&, int first, int last)
+{
+  AlertListModel* model = AlertListModel::instance();
+  if (!model)
+    return;
+
+  bool changed = false;
+  for (int row = first; row <= last; ++row)
   {
-    AlertConditionData* alert = model->alertAt(i);
-    if (!alert)
-      continue;
+    if (removeAlert(model->alertAt(row)))
+      changed = true;
+  }
+
+  if (changed)
+    emit unviewedCountChanged();
+}
 
-    if (!alert->isActive())
-      continue;
+/*!
+  \internal
+
+  Recounts all of the alerts in the model.
+ */
+void ViewedAlertsController::handleModelReset()
+{
+  m_countedAlerts.clear();
+  m_levelCounts.fill(0);
+  m_count = 0;
+
+  AlertListModel* model = AlertListModel::instance();
+  if (model && model->rowCount() > 0)
+    handleDataChanged(model->index(0, 0), model->index(model->rowCount() - 1, 0));
+
+  emit unviewedCountChanged();
+}
+
+/*!
+  \internal
+
+  Adds, moves or removes \a alert in the counts, according to its current state.
+  The last evaluated active state is used so that no query is run.
 
-    if (!alert->isConditionEnabled())
-      continue;
+  Returns \c true if the counts changed.
+ */
+bool ViewedAlertsController::updateAlert(AlertConditionData* alert)
+{
+  if (!alert)
+    return false;
+
+  const bool counted = alert->isConditionEnabled() && alert->cachedQueryResult() && !alert->viewed();
+  if (!counted)
+    return removeAlert(alert);
 
-    if (alert->viewed())
-      continue;
+  const AlertLevel level = alert->level();
+  auto it = m_countedAlerts.find(alert);
+  if (it != m_countedAlerts.end())
+  {
+    if (it.value() == level)
+      return false;
 
-    count++;
+    m_levelCounts[static_cast<int>(it.value())]--;
+    m_levelCounts[static_cast<int>(level)]++;
+    it.value() = level;
+    return true;
   }
 
-  m_cachedCount = count;
+  m_countedAlerts.insert(alert, level);
+  m_levelCounts[static_cast<int>(level)]++;
+  m_count++;
+  return true;
+}
+
+/*!
+  \internal
+
+  Removes \a alert from the counts, if it is counted.
+
+  Returns \c true if the counts changed.
+ */
+bool ViewedAlertsController::removeAlert(AlertConditionData* alert)
+{
+  auto it = m_countedAlerts.find(alert);
+  if (it == m_countedAlerts.end())
+    return false;
 
-  return m_cachedCount;
+  m_levelCounts[static_cast<int>(it.value())]--;
+  m_countedAlerts.erase(it);
+  m_count--;
+  return true;
 }
 
 } // Dsa
@@ -133,5 +277,5 @@ int ViewedAlertsController::unviewedCount() const
 // Signal Documentation
 /*!
   \fn void ViewedAlertsController::unviewedCountChanged();
-  \brief Signal emitted when the unviewed count changes.
+  \brief Signal emitted when the unviewed count, or the count for any \l AlertLevel, changes.
  */
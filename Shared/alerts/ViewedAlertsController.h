@@ -20,12 +20,18 @@
 // toolkit headers
 #include "AbstractTool.h"
 
+// dsa app headers
+#include "AlertLevel.h"
+
 // Qt headers
 #include <QAbstractListModel>
+#include <QHash>
 #include <QObject>
+#include <QVector>
 
 namespace Dsa {
 
+class AlertConditionData;
 class AlertListProxyModel;
 class StatusAlertFilter;
 
@@ -34,12 +40,22 @@ class ViewedAlertsController : public AbstractTool
   Q_OBJECT
 
   Q_PROPERTY(int unviewedCount READ unviewedCount NOTIFY unviewedCountChanged)
+  Q_PROPERTY(int unviewedLowCount READ unviewedLowCount NOTIFY unviewedCountChanged)
+  Q_PROPERTY(int unviewedMediumCount READ unviewedMediumCount NOTIFY unviewedCountChanged)
+  Q_PROPERTY(int unviewedHighCount READ unviewedHighCount NOTIFY unviewedCountChanged)
+  Q_PROPERTY(int unviewedCriticalCount READ unviewedCriticalCount NOTIFY unviewedCountChanged)
 
 public:
   explicit ViewedAlertsController(QObject* parent = nullptr);
   ~ViewedAlertsController();
 
   int unviewedCount() const;
+  int unviewedLowCount() const;
+  int unviewedMediumCount() const;
+  int unviewedHighCount() const;
+  int unviewedCriticalCount() const;
+
+  Q_INVOKABLE int unviewedCountForLevel(int level) const;
 
   // AbstractTool interface
   QString toolName() const;
@@ -48,10 +64,18 @@ signals:
   void unviewedCountChanged();
 
 private slots:
-  void handleDataChanged();
+  void handleDataChanged(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+  void handleRowsInserted(const QModelIndex& parent, int first, int last);
+  void handleRowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+  void handleModelReset();
 
 private:
-  mutable int m_cachedCount = -1;
+  bool updateAlert(AlertConditionData* alert);
+  bool removeAlert(AlertConditionData* alert);
+
+  int m_count = 0;
+  QVector<int> m_levelCounts;
+  QHash<AlertConditionData*, AlertLevel> m_countedAlerts; // the unviewed, active alerts and the level they are counted at
 };
 
 } // Dsa
@@ -20,6 +20,7 @@
 #include "WithinAreaAlertCondition.h"
 
 // dsa app headers
+#include "AlertSpatialJoin.h"
 #include "GraphicAlertSource.h"
 #include "WithinAreaAlertConditionData.h"
 
@@ -68,7 +69,48 @@ WithinAreaAlertCondition::~WithinAreaAlertCondition()
  */
 AlertConditionData* WithinAreaAlertCondition::createData(AlertSource* source, AlertTarget* target)
 {
-  return new WithinAreaAlertConditionData(newConditionDataName(), level(), source, target, this);
+  return new WithinAreaAlertConditionData(newConditionDataName(source), level(), source, target, this);
+}
+
+/*!
+  \brief Returns an evaluation of whether each of the \a sources lies within the \a target.
+
+  The source locations and the prepared target polygons covering them are captured when the evaluation
+  is created. All of the locations are then tested in one pass using \l AlertSpatialJoin.
+ */
+AlertCondition::Evaluation WithinAreaAlertCondition::createEvaluation(AlertTarget* target, const QList<AlertSource*>& sources) const
+{
+  QVector<double> lons;
+  QVector<double> lats;
+  wgs84SourceLocations(sources, lons, lats);
+
+  // the snapshot extends beyond the sources, so that the slack of sources outside every polygon can be measured
+  const Envelope searchArea = AlertSpatialJoin::searchArea(lons, lats, AlertSpatialJoin::SlackHorizon);
+  const AlertSpatialJoin::TargetSnapshot snapshot = AlertSpatialJoin::snapshotTargetPolygons(target, searchArea);
+
+  return [snapshot, lons, lats](EvaluationResults& results)
+  {
+    AlertSpatialJoin::withinArea(snapshot, lons, lats, results.matches, &results.slacks);
+    results.lons = lons;
+    results.lats = lats;
+  };
+}
+
+/*!
+  \brief Returns \c AlertChange::Geometry: the query is not affected by changes to attributes.
+ */
+AlertChanges WithinAreaAlertCondition::dependencies() const
+{
+  return AlertChange::Geometry;
+}
+
+/*!
+  \brief Returns the slack horizon: an area which is further than this from a source does not
+  affect its result, or the slack measured for it.
+ */
+double WithinAreaAlertCondition::targetInfluenceDistance() const
+{
+  return AlertSpatialJoin::SlackHorizon;
 }
 
 /*!
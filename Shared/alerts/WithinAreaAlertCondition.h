@@ -41,6 +41,12 @@ public:
   QString queryString() const override;
   QVariantMap queryComponents() const override;
 
+  AlertChanges dependencies() const override;
+  double targetInfluenceDistance() const override;
+
+protected:
+  Evaluation createEvaluation(AlertTarget* target, const QList<AlertSource*>& sources) const override;
+
   static QString isWithinQueryString();
 };
 
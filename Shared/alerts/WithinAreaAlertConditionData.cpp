@@ -22,10 +22,10 @@
 // dsa app headers
 #include "AlertSource.h"
 #include "AlertTarget.h"
+#include "PreparedPolygon.h"
 
 // C++ API headers
 #include "GeoElement.h"
-#include "GeometryEngine.h"
 #include "Point.h"
 
 using namespace Esri::ArcGISRuntime;
@@ -83,21 +83,22 @@ bool WithinAreaAlertConditionData::matchesQuery() const
   if (!isQueryOutOfDate())
     return cachedQueryResult();
 
-  Geometry sourceWgs84 = GeometryEngine::project(sourceLocation(), SpatialReference::wgs84());
-  const QList<Geometry> targetGeometries = target()->targetGeometries(sourceWgs84.extent());
+  const Point sourceWgs84 = source()->wgs84Location();
+  if (sourceWgs84.isEmpty())
+    return false;
 
-  for (const Geometry& target : targetGeometries)
+  bool withinArea = false;
+
+  // the target polygons are prepared in WGS84, so only the edges near the source are tested
+  target()->visitTargetPolygons(sourceWgs84.extent(), [&sourceWgs84, &withinArea](const std::shared_ptr<const PreparedPolygon>& targetWgs84)
   {
-    if (target.geometryType() != GeometryType::Polygon)
-      continue;
+    withinArea = targetWgs84->contains(sourceWgs84.x(), sourceWgs84.y());
 
-    const Geometry targetWgs84 = GeometryEngine::project(target, sourceWgs84.spatialReference());
-    if (GeometryEngine::instance()->intersects(sourceWgs84, targetWgs84))
-      return true;
-  }
+    // stop once a containing target is found
+    return !withinArea;
+  });
 
-  return false;
+  return withinArea;
 }
 
-
 } // Dsa
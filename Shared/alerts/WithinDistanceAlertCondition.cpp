@@ -20,6 +20,8 @@
 #include "WithinDistanceAlertCondition.h"
 
 // dsa app headers
+#include "AlertScheduler.h"
+#include "AlertSpatialJoin.h"
 #include "AlertConstants.h"
 #include "WithinDistanceAlertConditionData.h"
 
@@ -66,7 +68,7 @@ WithinDistanceAlertCondition::~WithinDistanceAlertCondition()
  */
 AlertConditionData* WithinDistanceAlertCondition::createData(AlertSource* source, AlertTarget* target)
 {
-  return new WithinDistanceAlertConditionData(newConditionDataName(), level(), source, target, m_distance, this);
+  return new WithinDistanceAlertConditionData(newConditionDataName(source), level(), source, target, m_distance, this);
 }
 
 /*!
@@ -104,6 +106,51 @@ double WithinDistanceAlertCondition::getDistanceFromQueryComponents(const QVaria
   return queryComponents.value(AlertConstants::METERS, -1.0).toDouble();
 }
 
+/*!
+  \brief Returns an evaluation of whether each of the \a sources lies within the threshold
+  distance of the \a target.
+
+  The source locations and the target geometries covering them are captured when the evaluation
+  is created. All of the locations are then tested in one pass using \l AlertSpatialJoin, using
+  local frames if the \l AlertScheduler has a local frame tolerance.
+ */
+AlertCondition::Evaluation WithinDistanceAlertCondition::createEvaluation(AlertTarget* target, const QList<AlertSource*>& sources) const
+{
+  QVector<double> lons;
+  QVector<double> lats;
+  wgs84SourceLocations(sources, lons, lats);
+  const double distance = m_distance;
+  const double localFrameTolerance = AlertScheduler::instance()->localFrameTolerance();
+
+  // the snapshot extends beyond the distance, so that the slack of sources which do not match can be measured
+  const Envelope searchArea = AlertSpatialJoin::searchArea(lons, lats, distance + AlertSpatialJoin::SlackHorizon);
+  const AlertSpatialJoin::TargetSnapshot snapshot = AlertSpatialJoin::snapshotTarget(target, searchArea);
+
+  return [snapshot, lons, lats, distance, localFrameTolerance](EvaluationResults& results)
+  {
+    AlertSpatialJoin::withinDistance(snapshot, distance, lons, lats, results.matches, &results.slacks, localFrameTolerance);
+    results.lons = lons;
+    results.lats = lats;
+  };
+}
+
+/*!
+  \brief Returns \c AlertChange::Geometry: the query is not affected by changes to attributes.
+ */
+AlertChanges WithinDistanceAlertCondition::dependencies() const
+{
+  return AlertChange::Geometry;
+}
+
+/*!
+  \brief Returns the threshold distance plus the slack horizon: a target further than this from
+  a source does not affect its result, or the slack measured for it.
+ */
+double WithinDistanceAlertCondition::targetInfluenceDistance() const
+{
+  return m_distance + AlertSpatialJoin::SlackHorizon;
+}
+
 /*!
   \brief Returns the query string component for this condition - e.g. "is within X meters of".
  */
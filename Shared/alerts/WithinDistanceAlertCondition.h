@@ -43,10 +43,16 @@ public:
   QString queryString() const override;
   QVariantMap queryComponents() const override;
 
+  AlertChanges dependencies() const override;
+  double targetInfluenceDistance() const override;
+
   double distance() const;
 
   static double getDistanceFromQueryComponents(const QVariantMap& queryComponents);
 
+protected:
+  Evaluation createEvaluation(AlertTarget* target, const QList<AlertSource*>& sources) const override;
+
 private:
   double m_distance;
 };
@@ -20,18 +20,15 @@
 #include "WithinDistanceAlertConditionData.h"
 
 // dsa app headers
+#include "AlertScheduler.h"
 #include "AlertSource.h"
 #include "AlertTarget.h"
 
 // C++ API headers
 #include "GeoElement.h"
-#include "GeometryEngine.h"
 #include "Graphic.h"
 #include "Point.h"
 
-// STL headers
-#include <cmath>
-
 using namespace Esri::ArcGISRuntime;
 
 namespace Dsa {
@@ -44,6 +41,11 @@ namespace Dsa {
 
   This condition data allows a query to determine whether a source object is within a threshold
   distance of a target object, or objects.
+
+  The distance is measured to the nearest part of each target geometry using
+  \l AlertTarget::nearestTargetDistance. If the \l AlertScheduler has a local frame tolerance,
+  distances are measured with planar arithmetic in a local frame at the source whenever the
+  error bound of the frame is within the tolerance, and on the sphere otherwise.
  */
 
 /*!
@@ -67,8 +69,7 @@ WithinDistanceAlertConditionData::WithinDistanceAlertConditionData(const QString
                                                                    double distance,
                                                                    QObject* parent):
   AlertConditionData(name, level, source, target, parent),
-  m_distance(distance),
-  m_moveDistance(std::sqrt((m_distance * m_distance) + (m_distance * m_distance)))
+  m_distance(distance)
 {
 
 }
@@ -98,38 +99,8 @@ bool WithinDistanceAlertConditionData::matchesQuery() const
   if (!isQueryOutOfDate())
     return cachedQueryResult();
 
-  // get 2 new points by moving the source position in a NE and SW position
-  // m_moveDistance is the hypotenuse of the triangle with opposite and adjacent of distance
-  const QList<Point> southWest = GeometryEngine::moveGeodetic(QList<Point>{sourceLocation()}, m_moveDistance,
-                                                              LinearUnit::meters(), 225.0, AngularUnit::degrees(),
-                                                              GeodeticCurveType::Geodesic);
-  const QList<Point> northEast = GeometryEngine::moveGeodetic(QList<Point>{sourceLocation()}, m_moveDistance,
-                                                              LinearUnit::meters(), 45.0, AngularUnit::degrees(),
-                                                              GeodeticCurveType::Geodesic);
-
-  // form an Envelope from these 2 extreme points and check for target geometrties within this extent
-  const Envelope distanceExtent(southWest.first(), northEast.first());
-  const QList<Geometry> targetGeometries = target()->targetGeometries(distanceExtent);
-
-  // if there are no target geometries within the distance extent, stop
-  if (targetGeometries.isEmpty())
-    return false;
-
-  // buffer the source position by the distance for an accurate within distance test
-  const Geometry bufferGeom = GeometryEngine::bufferGeodetic(sourceLocation(), distance(), LinearUnit::meters(), 1.0,
-                                                             GeodeticCurveType::Geodesic);
-  const Geometry bufferWgs84 = GeometryEngine::project(bufferGeom, SpatialReference::wgs84());
-
-  // test the buffer against all the target geometries
-  for (const Geometry& target : targetGeometries)
-  {
-    Geometry targetWgs84 = GeometryEngine::project(target, SpatialReference::wgs84());
-    if (GeometryEngine::intersects(bufferWgs84, targetWgs84))
-      return true;
-  }
-
-  return false;
+  // ask the target for the nearest geometry within the threshold distance of the source position
+  return target()->nearestTargetDistance(source()->wgs84Location(), distance(), AlertScheduler::instance()->localFrameTolerance()) >= 0.0;
 }
 
-
 } // Dsa
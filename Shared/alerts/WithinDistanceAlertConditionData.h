@@ -44,7 +44,6 @@ public:
 
 private:
   double m_distance = 0.0;
-  double m_moveDistance = 0.0;
 };
 
 } // Dsa
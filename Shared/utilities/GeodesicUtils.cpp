@@ -0,0 +1,583 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "GeodesicUtils.h"
+
+// C++ API headers
+#include "Geometry.h"
+#include "GeometryEngine.h"
+#include "Multipoint.h"
+#include "MultipointBuilder.h"
+#include "Part.h"
+#include "PartCollection.h"
+#include "Point.h"
+#include "PointCollection.h"
+#include "Polyline.h"
+#include "PolylineBuilder.h"
+#include "ProximityResult.h"
+
+// Qt headers
+#include <QVarLengthArray>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+constexpr double Pi = 3.14159265358979323846;
+constexpr double DegreesToRadians = Pi / 180.0;
+
+// local frames which reach beyond this latitude (in radians) have no error bound
+constexpr double MaxLocalFrameLatitude = 89.0 * DegreesToRadians;
+
+// the error, in meters, allowed for rounding in the great-circle functions which local frames approximate
+constexpr double LocalFrameRoundingError = 0.01;
+
+// returns the longitude \a lon, shifted by multiples of 360 degrees to be as close as possible to \a reference
+double nearestLongitude(double lon, double reference)
+{
+  while (lon - reference > 180.0)
+    lon -= 360.0;
+
+  while (reference - lon > 180.0)
+    lon += 360.0;
+
+  return lon;
+}
+
+// returns the distance from (\a lon, \a lat) to the closest point on the meridian \a meridianLon between \a yMin and \a yMax
+double distanceToMeridian(double lon, double lat, double meridianLon, double yMin, double yMax)
+{
+  // the distance to a point on the meridian is smallest at the foot of the perpendicular from the location.
+  // If that lies outside of the range, the closest point is one of the end points
+  const double lat1 = lat * DegreesToRadians;
+  const double deltaLon = (lon - meridianLon) * DegreesToRadians;
+  const double footLat = std::atan2(std::sin(lat1), std::cos(lat1) * std::cos(deltaLon)) / DegreesToRadians;
+  if (footLat >= yMin && footLat <= yMax)
+    return GeodesicUtils::distance(lon, lat, meridianLon, footLat);
+
+  return std::min(GeodesicUtils::distance(lon, lat, meridianLon, yMin),
+                  GeodesicUtils::distance(lon, lat, meridianLon, yMax));
+}
+
+// a location on the unit sphere
+struct UnitVector
+{
+  double x = 0.0;
+  double y = 0.0;
+  double z = 0.0;
+};
+
+UnitVector toUnitVector(double lon, double lat)
+{
+  const double lonRadians = lon * DegreesToRadians;
+  const double latRadians = lat * DegreesToRadians;
+  const double cosLat = std::cos(latRadians);
+  return UnitVector{cosLat * std::cos(lonRadians), cosLat * std::sin(lonRadians), std::sin(latRadians)};
+}
+
+UnitVector cross(const UnitVector& a, const UnitVector& b)
+{
+  return UnitVector{(a.y * b.z) - (a.z * b.y), (a.z * b.x) - (a.x * b.z), (a.x * b.y) - (a.y * b.x)};
+}
+
+double dot(const UnitVector& a, const UnitVector& b)
+{
+  return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
+}
+
+// returns the planar distance from the origin to the segment between (x1, y1) and (x2, y2)
+double planarDistanceToSegment(double x1, double y1, double x2, double y2)
+{
+  const double dx = x2 - x1;
+  const double dy = y2 - y1;
+  const double lengthSquared = (dx * dx) + (dy * dy);
+
+  // the parameter of the foot of the perpendicular from the origin, clamped to the segment
+  const double t = lengthSquared > 0.0 ? std::max(0.0, std::min(1.0, -((x1 * dx) + (y1 * dy)) / lengthSquared)) : 0.0;
+  const double x = x1 + (t * dx);
+  const double y = y1 + (t * dy);
+  return std::sqrt((x * x) + (y * y));
+}
+}
+
+/*!
+  \struct Dsa::GeodesicUtils::PackedGeometry
+  \inmodule Dsa
+  \brief The WGS84 coordinates of a point, multipoint or polyline stored in packed arrays.
+
+  Packing a geometry once allows distances to it to be calculated repeatedly without
+  calling \l Esri::ArcGISRuntime::GeometryEngine.
+
+  \sa GeodesicUtils::pack
+ */
+
+/*!
+  \brief Removes all coordinates.
+ */
+void GeodesicUtils::PackedGeometry::clear()
+{
+  lons.clear();
+  lats.clear();
+  partOffsets.clear();
+  isPath = false;
+}
+
+/*!
+  \namespace Dsa::GeodesicUtils
+  \inmodule Dsa
+  \brief Closed-form distance calculations for WGS84 coordinates.
+
+  Distances are calculated on a sphere with the mean radius of the earth (\l EarthRadius).
+  They are within 0.5% of the geodesic distance on the WGS84 ellipsoid, which makes them suitable for
+  spatial indexing and for threshold tests which do not need to call \l Esri::ArcGISRuntime::GeometryEngine.
+
+  Points, multipoints and polylines can be packed into coordinate arrays (\l PackedGeometry) and measured
+  using the haversine and cross-track formulae. Polygons fall back to the GeometryEngine.
+
+  For short distances, a \l LocalFrame measures packed geometry with planar arithmetic instead, and
+  reports a bound for the error which that introduces.
+ */
+
+/*!
+  \brief Returns the great-circle distance, in meters, between (\a lon1, \a lat1) and (\a lon2, \a lat2).
+
+  The coordinates are in decimal degrees. The haversine formula is used so that short distances are accurate.
+ */
+double GeodesicUtils::distance(double lon1, double lat1, double lon2, double lat2)
+{
+  const double sinDeltaLat = std::sin((lat2 - lat1) * DegreesToRadians * 0.5);
+  const double sinDeltaLon = std::sin((lon2 - lon1) * DegreesToRadians * 0.5);
+  const double a = (sinDeltaLat * sinDeltaLat) +
+                   (std::cos(lat1 * DegreesToRadians) * std::cos(lat2 * DegreesToRadians) * sinDeltaLon * sinDeltaLon);
+
+  return 2.0 * EarthRadius * std::asin(std::min(1.0, std::sqrt(a)));
+}
+
+/*!
+  \brief Calculates the great-circle distance, in meters, from (\a lon, \a lat) to each of the \a count
+  locations in the packed \a lons and \a lats arrays, writing them to \a results.
+
+  The loop has no branches, so it can be vectorized by the compiler.
+ */
+void GeodesicUtils::distances(double lon, double lat, const double* lons, const double* lats, int count, double* results)
+{
+  const double cosLat = std::cos(lat * DegreesToRadians);
+  for (int i = 0; i < count; ++i)
+  {
+    const double sinDeltaLat = std::sin((lats[i] - lat) * DegreesToRadians * 0.5);
+    const double sinDeltaLon = std::sin((lons[i] - lon) * DegreesToRadians * 0.5);
+    const double a = (sinDeltaLat * sinDeltaLat) +
+                     (cosLat * std::cos(lats[i] * DegreesToRadians) * sinDeltaLon * sinDeltaLon);
+    results[i] = 2.0 * EarthRadius * std::asin(std::sqrt(std::min(1.0, a)));
+  }
+}
+
+/*!
+  \brief Returns the distance, in meters, from (\a lon, \a lat) to the great-circle segment
+  between (\a lon1, \a lat1) and (\a lon2, \a lat2).
+
+  If the foot of the perpendicular (cross-track) from the location lies between the end points, the
+  cross-track distance is returned. Otherwise the distance to the nearest end point is returned.
+ */
+double GeodesicUtils::distanceToSegment(double lon, double lat, double lon1, double lat1, double lon2, double lat2)
+{
+  const UnitVector p = toUnitVector(lon, lat);
+  const UnitVector a = toUnitVector(lon1, lat1);
+  const UnitVector b = toUnitVector(lon2, lat2);
+
+  // the normal to the plane of the great circle through the end points
+  const UnitVector n = cross(a, b);
+  const double nLength = std::sqrt(dot(n, n));
+  const double endPointDistance = std::min(distance(lon, lat, lon1, lat1), distance(lon, lat, lon2, lat2));
+
+  // a zero-length segment is just a point
+  if (nLength < 1e-15)
+    return endPointDistance;
+
+  // the foot of the perpendicular lies within the segment if it is on the inner side of both end points
+  const double sinCrossTrack = dot(p, n) / nLength;
+  const UnitVector foot{p.x - (sinCrossTrack * n.x / nLength),
+                        p.y - (sinCrossTrack * n.y / nLength),
+                        p.z - (sinCrossTrack * n.z / nLength)};
+  if (dot(cross(a, foot), n) < 0.0 || dot(cross(foot, b), n) < 0.0)
+    return endPointDistance;
+
+  // the foot of the perpendicular must also be on the same side of the sphere as the segment
+  if (dot(foot, a) < 0.0 && dot(foot, b) < 0.0)
+    return endPointDistance;
+
+  return std::min(endPointDistance, std::abs(std::asin(std::max(-1.0, std::min(1.0, sinCrossTrack)))) * EarthRadius);
+}
+
+/*!
+  \brief Returns the distance, in meters, from (\a lon, \a lat) to the path joining the \a count
+  locations in the packed \a lons and \a lats arrays.
+ */
+double GeodesicUtils::distanceToPath(double lon, double lat, const double* lons, const double* lats, int count)
+{
+  if (count <= 0)
+    return -1.0;
+
+  if (count == 1)
+    return distance(lon, lat, lons[0], lats[0]);
+
+  double nearest = std::numeric_limits<double>::max();
+  for (int i = 1; i < count; ++i)
+    nearest = std::min(nearest, distanceToSegment(lon, lat, lons[i - 1], lats[i - 1], lons[i], lats[i]));
+
+  return nearest;
+}
+
+/*!
+  \brief Packs the coordinates of \a wgs84Geometry into \a packed.
+
+  Only points, multipoints and polylines can be packed. Returns \c false for other geometry
+  types (e.g. polygons) which should be tested using \l distanceToGeometry.
+ */
+bool GeodesicUtils::pack(const Geometry& wgs84Geometry, PackedGeometry& packed)
+{
+  packed.clear();
+  if (wgs84Geometry.isEmpty())
+    return false;
+
+  switch (wgs84Geometry.geometryType())
+  {
+  case GeometryType::Point:
+  {
+    const Point point(wgs84Geometry);
+    packed.partOffsets.append(0);
+    packed.lons.append(point.x());
+    packed.lats.append(point.y());
+    return true;
+  }
+  case GeometryType::Multipoint:
+  {
+    QObject localParent;
+    MultipointBuilder* builder = new MultipointBuilder(Multipoint(wgs84Geometry), &localParent);
+    PointCollection* points = builder->points();
+    const int count = points ? points->size() : 0;
+    packed.partOffsets.append(0);
+    packed.lons.reserve(count);
+    packed.lats.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+      const Point point = points->point(i);
+      packed.lons.append(point.x());
+      packed.lats.append(point.y());
+    }
+
+    return !packed.isEmpty();
+  }
+  case GeometryType::Polyline:
+  {
+    QObject localParent;
+    PolylineBuilder* builder = new PolylineBuilder(Polyline(wgs84Geometry), &localParent);
+    PartCollection* parts = builder->parts();
+    const int partCount = parts ? parts->size() : 0;
+    for (int partIndex = 0; partIndex < partCount; ++partIndex)
+    {
+      Part* part = parts->part(partIndex);
+      if (!part)
+        continue;
+
+      packed.partOffsets.append(packed.lons.size());
+      const int pointCount = part->pointCount();
+      for (int i = 0; i < pointCount; ++i)
+      {
+        const Point point = part->point(i);
+        packed.lons.append(point.x());
+        packed.lats.append(point.y());
+      }
+    }
+
+    packed.isPath = true;
+    return !packed.isEmpty();
+  }
+  default:
+    break;
+  }
+
+  return false;
+}
+
+/*!
+  \brief Returns the distance, in meters, from (\a lon, \a lat) to the nearest part of the \a packed geometry.
+
+  Returns a negative value if \a packed is empty.
+ */
+double GeodesicUtils::distanceToPacked(double lon, double lat, const PackedGeometry& packed)
+{
+  if (packed.isEmpty())
+    return -1.0;
+
+  double nearest = std::numeric_limits<double>::max();
+  const int partCount = packed.partOffsets.size();
+  for (int partIndex = 0; partIndex < partCount; ++partIndex)
+  {
+    const int start = packed.partOffsets.at(partIndex);
+    const int end = (partIndex + 1 < partCount) ? packed.partOffsets.at(partIndex + 1) : packed.lons.size();
+    const int count = end - start;
+    if (count <= 0)
+      continue;
+
+    if (packed.isPath)
+    {
+      nearest = std::min(nearest, distanceToPath(lon, lat, packed.lons.constData() + start, packed.lats.constData() + start, count));
+      continue;
+    }
+
+    // measure to each of the points in a single pass
+    QVarLengthArray<double, 64> results(count);
+    distances(lon, lat, packed.lons.constData() + start, packed.lats.constData() + start, count, results.data());
+    nearest = std::min(nearest, *std::min_element(results.constBegin(), results.constEnd()));
+  }
+
+  return nearest;
+}
+
+/*!
+  \brief Returns the great-circle distance, in meters, from (\a lon, \a lat) to the closest point of the
+  latitude/longitude rectangle (\a xMin, \a yMin, \a xMax, \a yMax).
+
+  Returns \c 0 if the location lies within the rectangle. Since no part of a geometry can be closer than its
+  bounding rectangle, this is a lower bound for the distance to any geometry within the rectangle.
+ */
+double GeodesicUtils::distanceToBounds(double lon, double lat, double xMin, double yMin, double xMax, double yMax)
+{
+  // rectangles (e.g. quadtree cells) may extend beyond the valid range of latitudes
+  yMin = std::max(-90.0, std::min(90.0, yMin));
+  yMax = std::max(-90.0, std::min(90.0, yMax));
+
+  // a rectangle which spans all longitudes only differs in latitude
+  const bool allLongitudes = (xMax - xMin) >= 360.0;
+  lon = nearestLongitude(lon, (xMin + xMax) * 0.5);
+
+  if (allLongitudes || (lon >= xMin && lon <= xMax))
+  {
+    if (lat < yMin)
+      return (yMin - lat) * DegreesToRadians * EarthRadius;
+
+    if (lat > yMax)
+      return (lat - yMax) * DegreesToRadians * EarthRadius;
+
+    return 0.0;
+  }
+
+  // the closest point along either parallel lies at one of the corners, so the closest point
+  // of the rectangle must lie on one of the bounding meridians
+  return std::min(distanceToMeridian(lon, lat, xMin, yMin, yMax),
+                  distanceToMeridian(lon, lat, xMax, yMin, yMax));
+}
+
+/*!
+  \brief Returns the distance, in meters, from \a wgs84Location to the closest part of \a wgs84Geometry.
+
+  Returns \c 0 if the location lies within a polygon and a negative value if the geometry is empty.
+ */
+double GeodesicUtils::distanceToGeometry(const Point& wgs84Location, const Geometry& wgs84Geometry)
+{
+  if (wgs84Geometry.isEmpty())
+    return -1.0;
+
+  if (wgs84Geometry.geometryType() == GeometryType::Point)
+  {
+    const Point point(wgs84Geometry);
+    return distance(wgs84Location.x(), wgs84Location.y(), point.x(), point.y());
+  }
+
+  // use the closed-form kernels for multipoints and polylines
+  if (wgs84Geometry.geometryType() == GeometryType::Multipoint ||
+      wgs84Geometry.geometryType() == GeometryType::Polyline)
+  {
+    PackedGeometry packed;
+    if (pack(wgs84Geometry, packed))
+      return distanceToPacked(wgs84Location.x(), wgs84Location.y(), packed);
+  }
+
+  // fall back to the GeometryEngine for polygons and other types
+  if (wgs84Geometry.geometryType() == GeometryType::Polygon &&
+      GeometryEngine::intersects(wgs84Geometry, wgs84Location))
+  {
+    return 0.0;
+  }
+
+  // find the closest coordinate of the geometry and measure the great-circle distance to it
+  const ProximityResult nearest = GeometryEngine::nearestCoordinate(wgs84Geometry, wgs84Location);
+  const Point coordinate = nearest.coordinate();
+  if (coordinate.isEmpty())
+    return -1.0;
+
+  return distance(wgs84Location.x(), wgs84Location.y(), coordinate.x(), coordinate.y());
+}
+
+/*!
+  \brief Calculates a latitude/longitude rectangle (\a xMin, \a yMin, \a xMax, \a yMax) which contains every
+  location within \a distance meters of (\a lon, \a lat).
+ */
+void GeodesicUtils::boundsForDistance(double lon, double lat, double distance, double& xMin, double& yMin, double& xMax, double& yMax)
+{
+  const double deltaLat = (distance / EarthRadius) / DegreesToRadians;
+  yMin = std::max(-90.0, lat - deltaLat);
+  yMax = std::min(90.0, lat + deltaLat);
+
+  // the width of a degree of longitude is smallest at the latitude furthest from the equator
+  const double maxCosLat = std::cos(std::max(std::abs(yMin), std::abs(yMax)) * DegreesToRadians);
+  const double deltaLon = (maxCosLat > 0.0) ? (deltaLat / maxCosLat) : 180.0;
+  xMin = lon - std::min(180.0, deltaLon);
+  xMax = lon + std::min(180.0, deltaLon);
+}
+
+/*!
+  \class Dsa::GeodesicUtils::LocalFrame
+  \inmodule Dsa
+  \brief A local east-north-up (tangent plane) frame, in which distances from its origin are
+  measured with planar arithmetic.
+
+  Locations are converted to meters east and north of the origin by scaling their offsets in
+  longitude and latitude. Within the \l radius of the origin, distances measured in the frame
+  differ from great-circle distances by no more than the \l errorBound. This grows with the
+  square of the radius and with the latitude, so it is small for thresholds of a few kilometers
+  away from the poles.
+
+  Users of a frame should check \l isWithinTolerance, and fall back to the great-circle functions
+  if the error could be too large. Parts of a geometry which lie beyond the radius are always
+  measured with the great-circle functions.
+ */
+
+/*!
+  \brief Constructor for a frame with its origin at (\a lon, \a lat), for distances of up to
+  \a radius meters.
+ */
+GeodesicUtils::LocalFrame::LocalFrame(double lon, double lat, double radius):
+  m_lon(lon),
+  m_lat(lat),
+  m_radius(std::max(0.0, radius)),
+  m_metersPerDegreeLon(EarthRadius * DegreesToRadians * std::cos(lat * DegreesToRadians)),
+  m_metersPerDegreeLat(EarthRadius * DegreesToRadians),
+  m_errorBound(std::numeric_limits<double>::infinity())
+{
+  // the angular radius of the frame, and the furthest latitude from the equator which it covers
+  const double angle = m_radius / EarthRadius;
+  const double originLat = std::abs(lat) * DegreesToRadians;
+  const double maxLat = originLat + angle;
+  if (std::isnan(maxLat) || maxLat > MaxLocalFrameLatitude)
+    return;
+
+  // east-west offsets are scaled for the latitude of the origin rather than that of the location,
+  // and straight lines in the frame bow away from the great circles between their end points
+  const double cosOriginLat = std::cos(originLat);
+  const double scaleError = std::max(1.0 - (std::cos(maxLat) / cosOriginLat),
+                                     (std::cos(std::max(0.0, originLat - angle)) / cosOriginLat) - 1.0);
+  const double bowError = 0.5 * angle * std::tan(maxLat);
+
+  // the curvature of the earth adds an error of the order of the square of the angle
+  m_errorBound = (m_radius * (scaleError + bowError + (angle * angle))) + LocalFrameRoundingError;
+}
+
+/*!
+  \fn double GeodesicUtils::LocalFrame::radius() const
+  \brief Returns the distance, in meters, from the origin within which the frame is used.
+ */
+
+/*!
+  \fn double GeodesicUtils::LocalFrame::errorBound() const
+  \brief Returns the largest error, in meters, of a distance measured in the frame.
+
+  The bound is infinite for a frame which reaches too close to a pole.
+ */
+
+/*!
+  \brief Returns whether the \l errorBound is no more than \a tolerance meters.
+
+  A negative \a tolerance disables the frame.
+ */
+bool GeodesicUtils::LocalFrame::isWithinTolerance(double tolerance) const
+{
+  return tolerance >= 0.0 && m_errorBound <= tolerance;
+}
+
+/*!
+  \brief Converts (\a lon, \a lat) to the offsets, in meters, \a east and \a north of the origin.
+ */
+void GeodesicUtils::LocalFrame::toLocal(double lon, double lat, double& east, double& north) const
+{
+  east = (nearestLongitude(lon, m_lon) - m_lon) * m_metersPerDegreeLon;
+  north = (lat - m_lat) * m_metersPerDegreeLat;
+}
+
+/*!
+  \brief Returns the distance, in meters, from the origin to the nearest part of the \a packed geometry.
+
+  Points and segments within the \l radius are measured in the frame. Any others are measured
+  using \l distance and \l distanceToSegment. Returns a negative value if \a packed is empty.
+ */
+double GeodesicUtils::LocalFrame::distanceToPacked(const PackedGeometry& packed) const
+{
+  if (packed.isEmpty())
+    return -1.0;
+
+  const double radiusSquared = m_radius * m_radius;
+  double nearest = std::numeric_limits<double>::max();
+  const int partCount = packed.partOffsets.size();
+  for (int partIndex = 0; partIndex < partCount; ++partIndex)
+  {
+    const int start = packed.partOffsets.at(partIndex);
+    const int end = (partIndex + 1 < partCount) ? packed.partOffsets.at(partIndex + 1) : packed.lons.size();
+    const bool isPath = packed.isPath && (end - start) > 1;
+
+    double previousEast = 0.0;
+    double previousNorth = 0.0;
+    bool previousInFrame = false;
+    for (int i = start; i < end; ++i)
+    {
+      const double lon = packed.lons.at(i);
+      const double lat = packed.lats.at(i);
+      double east = 0.0;
+      double north = 0.0;
+      toLocal(lon, lat, east, north);
+      const double distanceSquared = (east * east) + (north * north);
+      const bool inFrame = distanceSquared <= radiusSquared;
+
+      if (!isPath)
+      {
+        nearest = std::min(nearest, inFrame ? std::sqrt(distanceSquared) : distance(m_lon, m_lat, lon, lat));
+      }
+      else if (i > start)
+      {
+        nearest = std::min(nearest, (inFrame && previousInFrame) ? planarDistanceToSegment(previousEast, previousNorth, east, north)
+                                                                 : distanceToSegment(m_lon, m_lat, packed.lons.at(i - 1), packed.lats.at(i - 1), lon, lat));
+      }
+
+      previousEast = east;
+      previousNorth = north;
+      previousInFrame = inFrame;
+    }
+  }
+
+  return nearest;
+}
+
+} // Dsa
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef GEODESICUTILS_H
+#define GEODESICUTILS_H
+
+// Qt headers
+#include <QVector>
+
+namespace Esri {
+namespace ArcGISRuntime {
+  class Geometry;
+  class Point;
+}
+}
+
+namespace Dsa {
+
+namespace GeodesicUtils
+{
+  // mean radius of the earth, in meters
+  constexpr double EarthRadius = 6371008.8;
+
+  // the WGS84 coordinates of a point, multipoint or polyline, stored as packed arrays
+  struct PackedGeometry
+  {
+    QVector<double> lons;
+    QVector<double> lats;
+    QVector<int> partOffsets; // the index of the first coordinate in each part
+    bool isPath = false; // whether consecutive coordinates in a part are joined by segments
+
+    bool isEmpty() const { return lons.isEmpty(); }
+    void clear();
+  };
+
+  // a local east-north-up frame at an origin, in which distances near the origin are measured with planar arithmetic
+  class LocalFrame
+  {
+  public:
+    LocalFrame(double lon, double lat, double radius);
+
+    double radius() const { return m_radius; }
+    double errorBound() const { return m_errorBound; }
+    bool isWithinTolerance(double tolerance) const;
+
+    void toLocal(double lon, double lat, double& east, double& north) const;
+    double distanceToPacked(const PackedGeometry& packed) const;
+
+  private:
+    double m_lon = 0.0;
+    double m_lat = 0.0;
+    double m_radius = 0.0;
+    double m_metersPerDegreeLon = 0.0;
+    double m_metersPerDegreeLat = 0.0;
+    double m_errorBound = 0.0;
+  };
+
+  double distance(double lon1, double lat1, double lon2, double lat2);
+  void distances(double lon, double lat, const double* lons, const double* lats, int count, double* results);
+  double distanceToSegment(double lon, double lat, double lon1, double lat1, double lon2, double lat2);
+  double distanceToPath(double lon, double lat, const double* lons, const double* lats, int count);
+  bool pack(const Esri::ArcGISRuntime::Geometry& wgs84Geometry, PackedGeometry& packed);
+  double distanceToPacked(double lon, double lat, const PackedGeometry& packed);
+  double distanceToBounds(double lon, double lat, double xMin, double yMin, double xMax, double yMax);
+  double distanceToGeometry(const Esri::ArcGISRuntime::Point& wgs84Location, const Esri::ArcGISRuntime::Geometry& wgs84Geometry);
+  void boundsForDistance(double lon, double lat, double distance, double& xMin, double& yMin, double& xMax, double& yMax);
+}
+
+} // Dsa
+
+#endif // GEODESICUTILS_H
@@ -0,0 +1,342 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef ORDERSTATISTICSTREE_H
+#define ORDERSTATISTICSTREE_H
+
+// Qt headers
+#include <QtGlobal>
+
+// STL headers
+#include <functional>
+#include <vector>
+
+namespace Dsa {
+
+template <typename T, typename Compare = std::less<T>>
+class OrderStatisticsTree
+{
+public:
+  int size() const;
+  bool isEmpty() const;
+  void clear();
+
+  int insert(const T& value);
+  int remove(const T& value);
+
+  const T& at(int rank) const;
+  int rankOf(const T& value) const;
+  int lowerBound(const T& value) const;
+
+private:
+  struct Node
+  {
+    T value;
+    quint32 priority = 0;
+    int left = -1;
+    int right = -1;
+    int size = 1;
+  };
+
+  int nodeSize(int node) const;
+  void update(int node);
+  int merge(int left, int right);
+  void split(int node, const T& value, int& left, int& right);
+  void splitFirst(int node, int& first, int& rest);
+  bool equivalent(const T& a, const T& b) const;
+  quint32 nextPriority();
+
+  std::vector<Node> m_nodes;
+  std::vector<int> m_freeNodes;
+  int m_root = -1;
+  quint32 m_seed = 2463534242u;
+  Compare m_compare;
+};
+
+/*!
+  \class Dsa::OrderStatisticsTree
+  \inmodule Dsa
+  \brief An ordered set of values which supports finding a value by its rank, and the rank
+  of a value, in logarithmic time.
+
+  The tree is a treap where each node stores the size of its subtree. Values are ordered using
+  \c Compare and must be unique with respect to it. Inserting or removing a value returns its rank,
+  which makes the tree suitable for maintaining the rows of a sorted model.
+ */
+
+/*!
+  \brief Returns the number of values in the tree.
+ */
+template <typename T, typename Compare>
+int OrderStatisticsTree<T, Compare>::size() const
+{
+  return nodeSize(m_root);
+}
+
+/*!
+  \brief Returns whether the tree contains no values.
+ */
+template <typename T, typename Compare>
+bool OrderStatisticsTree<T, Compare>::isEmpty() const
+{
+  return m_root == -1;
+}
+
+/*!
+  \brief Removes all values from the tree.
+ */
+template <typename T, typename Compare>
+void OrderStatisticsTree<T, Compare>::clear()
+{
+  m_nodes.clear();
+  m_freeNodes.clear();
+  m_root = -1;
+}
+
+/*!
+  \brief Inserts \a value and returns its rank.
+
+  \a value must not already be in the tree.
+ */
+template <typename T, typename Compare>
+int OrderStatisticsTree<T, Compare>::insert(const T& value)
+{
+  int node = -1;
+  if (m_freeNodes.empty())
+  {
+    node = static_cast<int>(m_nodes.size());
+    m_nodes.push_back(Node());
+  }
+  else
+  {
+    node = m_freeNodes.back();
+    m_freeNodes.pop_back();
+    m_nodes[node] = Node();
+  }
+
+  m_nodes[node].value = value;
+  m_nodes[node].priority = nextPriority();
+
+  int left = -1;
+  int right = -1;
+  split(m_root, value, left, right);
+
+  const int rank = nodeSize(left);
+  m_root = merge(merge(left, node), right);
+  return rank;
+}
+
+/*!
+  \brief Removes \a value and returns the rank it had, or \c -1 if it was not in the tree.
+ */
+template <typename T, typename Compare>
+int OrderStatisticsTree<T, Compare>::remove(const T& value)
+{
+  int left = -1;
+  int right = -1;
+  split(m_root, value, left, right);
+
+  int first = -1;
+  int rest = -1;
+  splitFirst(right, first, rest);
+
+  if (first == -1 || !equivalent(m_nodes[first].value, value))
+  {
+    m_root = merge(left, merge(first, rest));
+    return -1;
+  }
+
+  const int rank = nodeSize(left);
+  m_freeNodes.push_back(first);
+  m_root = merge(left, rest);
+  return rank;
+}
+
+/*!
+  \brief Returns the value at \a rank, which must be less than \l size.
+ */
+template <typename T, typename Compare>
+const T& OrderStatisticsTree<T, Compare>::at(int rank) const
+{
+  int node = m_root;
+  while (node != -1)
+  {
+    const int leftSize = nodeSize(m_nodes[node].left);
+    if (rank < leftSize)
+    {
+      node = m_nodes[node].left;
+    }
+    else if (rank == leftSize)
+    {
+      break;
+    }
+    else
+    {
+      rank -= leftSize + 1;
+      node = m_nodes[node].right;
+    }
+  }
+
+  Q_ASSERT(node != -1);
+  return m_nodes[node].value;
+}
+
+/*!
+  \brief Returns the rank of \a value, or \c -1 if it is not in the tree.
+ */
+template <typename T, typename Compare>
+int OrderStatisticsTree<T, Compare>::rankOf(const T& value) const
+{
+  const int rank = lowerBound(value);
+  if (rank < size() && equivalent(at(rank), value))
+    return rank;
+
+  return -1;
+}
+
+/*!
+  \brief Returns the number of values in the tree which are ordered before \a value.
+ */
+template <typename T, typename Compare>
+int OrderStatisticsTree<T, Compare>::lowerBound(const T& value) const
+{
+  int rank = 0;
+  int node = m_root;
+  while (node != -1)
+  {
+    if (m_compare(m_nodes[node].value, value))
+    {
+      rank += nodeSize(m_nodes[node].left) + 1;
+      node = m_nodes[node].right;
+    }
+    else
+    {
+      node = m_nodes[node].left;
+    }
+  }
+
+  return rank;
+}
+
+template <typename T, typename Compare>
+int OrderStatisticsTree<T, Compare>::nodeSize(int node) const
+{
+  return node == -1 ? 0 : m_nodes[node].size;
+}
+
+template <typename T, typename Compare>
+void OrderStatisticsTree<T, Compare>::update(int node)
+{
+  m_nodes[node].size = 1 + nodeSize(m_nodes[node].left) + nodeSize(m_nodes[node].right);
+}
+
+// joins two trees, where every value in left is ordered before every value in right
+template <typename T, typename Compare>
+int OrderStatisticsTree<T, Compare>::merge(int left, int right)
+{
+  if (left == -1)
+    return right;
+
+  if (right == -1)
+    return left;
+
+  if (m_nodes[left].priority > m_nodes[right].priority)
+  {
+    m_nodes[left].right = merge(m_nodes[left].right, right);
+    update(left);
+    return left;
+  }
+
+  m_nodes[right].left = merge(left, m_nodes[right].left);
+  update(right);
+  return right;
+}
+
+// splits the tree into the values ordered before value, and the rest
+template <typename T, typename Compare>
+void OrderStatisticsTree<T, Compare>::split(int node, const T& value, int& left, int& right)
+{
+  if (node == -1)
+  {
+    left = -1;
+    right = -1;
+    return;
+  }
+
+  if (m_compare(m_nodes[node].value, value))
+  {
+    int subLeft = -1;
+    split(m_nodes[node].right, value, subLeft, right);
+    m_nodes[node].right = subLeft;
+    left = node;
+  }
+  else
+  {
+    int subRight = -1;
+    split(m_nodes[node].left, value, left, subRight);
+    m_nodes[node].left = subRight;
+    right = node;
+  }
+
+  update(node);
+}
+
+// splits the first value of the tree from the rest
+template <typename T, typename Compare>
+void OrderStatisticsTree<T, Compare>::splitFirst(int node, int& first, int& rest)
+{
+  if (node == -1)
+  {
+    first = -1;
+    rest = -1;
+    return;
+  }
+
+  if (m_nodes[node].left == -1)
+  {
+    first = node;
+    rest = m_nodes[node].right;
+    m_nodes[node].right = -1;
+    update(node);
+    return;
+  }
+
+  int subRest = -1;
+  splitFirst(m_nodes[node].left, first, subRest);
+  m_nodes[node].left = subRest;
+  update(node);
+  rest = node;
+}
+
+template <typename T, typename Compare>
+bool OrderStatisticsTree<T, Compare>::equivalent(const T& a, const T& b) const
+{
+  return !m_compare(a, b) && !m_compare(b, a);
+}
+
+// xorshift, which is sufficient to keep the treap balanced
+template <typename T, typename Compare>
+quint32 OrderStatisticsTree<T, Compare>::nextPriority()
+{
+  m_seed ^= m_seed << 13;
+  m_seed ^= m_seed >> 17;
+  m_seed ^= m_seed << 5;
+  return m_seed;
+}
+
+} // Dsa
+
+#endif // ORDERSTATISTICSTREE_H
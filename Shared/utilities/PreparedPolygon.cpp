@@ -0,0 +1,353 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "PreparedPolygon.h"
+
+// C++ API headers
+#include "Geometry.h"
+#include "Part.h"
+#include "PartCollection.h"
+#include "Point.h"
+#include "Polygon.h"
+#include "PolygonBuilder.h"
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+constexpr double Pi = 3.14159265358979323846;
+constexpr double DegreesToRadians = Pi / 180.0;
+
+// the target number of edges in each band: fewer bands are used for polygons with few edges
+constexpr int EdgesPerBand = 2;
+
+// the maximum number of bands, which bounds the size of the index for very large polygons
+constexpr int MaxBands = 4096;
+}
+
+/*!
+  \class Dsa::PreparedPolygon
+  \inmodule Dsa
+  \brief A WGS84 polygon prepared for repeated point-in-polygon tests.
+
+  The edges of every ring are copied into packed arrays once, and indexed by a uniform grid
+  of horizontal bands covering the extent of the polygon. A point is tested using the
+  crossing-number (even-odd) rule, counting only the edges in the band which contains it,
+  so the cost of a test depends on the number of nearby edges rather than on the total
+  number of vertices. Holes are handled by the even-odd rule.
+
+  Coordinates are treated as planar longitude and latitude, in the same way as
+  \l Esri::ArcGISRuntime::GeometryEngine treats WGS84 geometry. Points which lie exactly
+  on an edge may be reported as either inside or outside.
+
+  A prepared polygon is immutable, so it can be shared between threads. It should be created
+  again whenever the source geometry changes.
+ */
+
+/*!
+  \brief Returns a prepared copy of the \a wgs84Polygon, or \c nullptr if it is not a
+  non-empty polygon.
+ */
+std::shared_ptr<const PreparedPolygon> PreparedPolygon::create(const Geometry& wgs84Polygon)
+{
+  if (wgs84Polygon.isEmpty() || wgs84Polygon.geometryType() != GeometryType::Polygon)
+    return nullptr;
+
+  GeodesicUtils::PackedGeometry rings;
+  QObject localParent;
+  PolygonBuilder* builder = new PolygonBuilder(Polygon(wgs84Polygon), &localParent);
+  PartCollection* parts = builder->parts();
+  const int partCount = parts ? parts->size() : 0;
+  for (int partIndex = 0; partIndex < partCount; ++partIndex)
+  {
+    Part* part = parts->part(partIndex);
+    if (!part)
+      continue;
+
+    rings.partOffsets.append(rings.lons.size());
+    const int pointCount = part->pointCount();
+    for (int i = 0; i < pointCount; ++i)
+    {
+      const Point point = part->point(i);
+      rings.lons.append(point.x());
+      rings.lats.append(point.y());
+    }
+  }
+
+  rings.isPath = true;
+  return create(rings);
+}
+
+/*!
+  \brief Returns a prepared polygon with the packed \a wgs84Rings, or \c nullptr if there are none.
+
+  Each part of \a wgs84Rings is a ring: the last coordinate is joined to the first.
+ */
+std::shared_ptr<const PreparedPolygon> PreparedPolygon::create(const GeodesicUtils::PackedGeometry& wgs84Rings)
+{
+  if (wgs84Rings.isEmpty())
+    return nullptr;
+
+  std::shared_ptr<PreparedPolygon> prepared(new PreparedPolygon());
+  prepared->build(wgs84Rings);
+  if (prepared->edgeCount() == 0)
+    return nullptr;
+
+  return prepared;
+}
+
+/*!
+  \brief Returns whether (\a lon, \a lat) lies within the polygon.
+
+  Polygons which extend beyond the antimeridian are also tested with the longitude shifted by
+  360 degrees.
+ */
+bool PreparedPolygon::contains(double lon, double lat) const
+{
+  if (std::isnan(lon) || std::isnan(lat) || lat < m_yMin || lat > m_yMax)
+    return false;
+
+  if (containsUnwrapped(lon, lat))
+    return true;
+
+  if (m_xMax > 180.0 && containsUnwrapped(lon + 360.0, lat))
+    return true;
+
+  return m_xMin < -180.0 && containsUnwrapped(lon - 360.0, lat);
+}
+
+/*!
+  \brief Returns the distance, in meters, from (\a lon, \a lat) to the nearest edge of the polygon,
+  or \a maxDistance if there is no edge nearer than that.
+
+  Only the edges in the bands within \a maxDistance of the point are measured. Distances are
+  measured in an equirectangular projection centered on the point, in which the edges are straight
+  lines as they are for \l contains. This is accurate for distances of a few kilometers.
+ */
+double PreparedPolygon::boundaryDistance(double lon, double lat, double maxDistance) const
+{
+  if (std::isnan(lon) || std::isnan(lat) || maxDistance <= 0.0)
+    return 0.0;
+
+  double nearest = boundaryDistanceUnwrapped(lon, lat, maxDistance);
+  if (m_xMax > 180.0)
+    nearest = boundaryDistanceUnwrapped(lon + 360.0, lat, nearest);
+
+  if (m_xMin < -180.0)
+    nearest = boundaryDistanceUnwrapped(lon - 360.0, lat, nearest);
+
+  return nearest;
+}
+
+/*!
+  \brief Returns the number of edges in the polygon.
+ */
+int PreparedPolygon::edgeCount() const
+{
+  return m_x1.size();
+}
+
+/*!
+  \internal
+
+  Copies the edges of each ring and assigns them to the bands which their latitudes overlap.
+ */
+void PreparedPolygon::build(const GeodesicUtils::PackedGeometry& wgs84Rings)
+{
+  const int coordinateCount = std::min(wgs84Rings.lons.size(), wgs84Rings.lats.size());
+  m_x1.reserve(coordinateCount);
+  m_y1.reserve(coordinateCount);
+  m_x2.reserve(coordinateCount);
+  m_y2.reserve(coordinateCount);
+
+  m_xMin = std::numeric_limits<double>::max();
+  m_yMin = std::numeric_limits<double>::max();
+  m_xMax = -std::numeric_limits<double>::max();
+  m_yMax = -std::numeric_limits<double>::max();
+
+  const int partCount = wgs84Rings.partOffsets.size();
+  for (int partIndex = 0; partIndex < partCount; ++partIndex)
+  {
+    const int first = wgs84Rings.partOffsets.at(partIndex);
+    const int end = partIndex + 1 < partCount ? wgs84Rings.partOffsets.at(partIndex + 1) : coordinateCount;
+    if (end - first < 3)
+      continue;
+
+    for (int i = first; i < end; ++i)
+    {
+      // the last coordinate is joined to the first, which adds a zero-length edge if the ring is already closed
+      const int next = i + 1 < end ? i + 1 : first;
+      const double x1 = wgs84Rings.lons.at(i);
+      const double y1 = wgs84Rings.lats.at(i);
+      const double x2 = wgs84Rings.lons.at(next);
+      const double y2 = wgs84Rings.lats.at(next);
+
+      m_x1.append(x1);
+      m_y1.append(y1);
+      m_x2.append(x2);
+      m_y2.append(y2);
+
+      m_xMin = std::min(m_xMin, std::min(x1, x2));
+      m_yMin = std::min(m_yMin, std::min(y1, y2));
+      m_xMax = std::max(m_xMax, std::max(x1, x2));
+      m_yMax = std::max(m_yMax, std::max(y1, y2));
+    }
+  }
+
+  const int edges = edgeCount();
+  if (edges == 0)
+    return;
+
+  const int bandCount = std::max(1, std::min(MaxBands, edges / EdgesPerBand));
+  m_bandHeight = (m_yMax - m_yMin) / bandCount;
+  if (m_bandHeight <= 0.0)
+    m_bandHeight = 1.0;
+
+  m_bandOffsets.fill(0, bandCount + 1);
+
+  // count the edges in each band, then fill them in (a counting sort), so that the edges of
+  // each band are stored contiguously
+  for (int edge = 0; edge < edges; ++edge)
+  {
+    const int firstBand = bandOf(std::min(m_y1.at(edge), m_y2.at(edge)));
+    const int lastBand = bandOf(std::max(m_y1.at(edge), m_y2.at(edge)));
+    for (int band = firstBand; band <= lastBand; ++band)
+      ++m_bandOffsets[band + 1];
+  }
+
+  for (int band = 0; band < bandCount; ++band)
+    m_bandOffsets[band + 1] += m_bandOffsets.at(band);
+
+  m_bandEdges.resize(m_bandOffsets.at(bandCount));
+  QVector<int> fill = m_bandOffsets;
+  for (int edge = 0; edge < edges; ++edge)
+  {
+    const int firstBand = bandOf(std::min(m_y1.at(edge), m_y2.at(edge)));
+    const int lastBand = bandOf(std::max(m_y1.at(edge), m_y2.at(edge)));
+    for (int band = firstBand; band <= lastBand; ++band)
+      m_bandEdges[fill[band]++] = edge;
+  }
+}
+
+/*!
+  \internal
+
+  Returns whether (\a lon, \a lat) lies within the polygon, by counting the edges in its band
+  which cross a ray from the point towards increasing longitude.
+ */
+bool PreparedPolygon::containsUnwrapped(double lon, double lat) const
+{
+  if (lon < m_xMin || lon > m_xMax)
+    return false;
+
+  const int band = bandOf(lat);
+
+  const int* edgeIt = m_bandEdges.constData() + m_bandOffsets.at(band);
+  const int* edgeEnd = m_bandEdges.constData() + m_bandOffsets.at(band + 1);
+  const double* x1 = m_x1.constData();
+  const double* y1 = m_y1.constData();
+  const double* x2 = m_x2.constData();
+  const double* y2 = m_y2.constData();
+
+  bool inside = false;
+  for (; edgeIt != edgeEnd; ++edgeIt)
+  {
+    const int edge = *edgeIt;
+
+    // the edge must straddle the latitude of the point (half-open, so shared vertices are counted
+    // once and horizontal edges are never counted)
+    if ((y1[edge] > lat) == (y2[edge] > lat))
+      continue;
+
+    const double crossingLon = x1[edge] + ((lat - y1[edge]) * (x2[edge] - x1[edge]) / (y2[edge] - y1[edge]));
+    if (lon < crossingLon)
+      inside = !inside;
+  }
+
+  return inside;
+}
+
+/*!
+  \brief internal
+
+  Returns the distance, in meters, from (\a lon, \a lat) to the nearest edge in the bands within
+  \a maxDistance of it, or \a maxDistance if there is none.
+ */
+double PreparedPolygon::boundaryDistanceUnwrapped(double lon, double lat, double maxDistance) const
+{
+  const double metersPerDegree = GeodesicUtils::EarthRadius * DegreesToRadians;
+  const double metersPerDegreeLon = metersPerDegree * std::cos(lat * DegreesToRadians);
+  const double maxDegrees = maxDistance / metersPerDegree;
+
+  if (lat + maxDegrees < m_yMin || lat - maxDegrees > m_yMax)
+    return maxDistance;
+
+  if (metersPerDegreeLon > 0.0 && (lon + (maxDistance / metersPerDegreeLon) < m_xMin || lon - (maxDistance / metersPerDegreeLon) > m_xMax))
+    return maxDistance;
+
+  const int firstBand = bandOf(lat - maxDegrees);
+  const int lastBand = bandOf(lat + maxDegrees);
+
+  // compare squared distances, so that only the nearest is square rooted
+  double nearestSquared = maxDistance * maxDistance;
+  for (int band = firstBand; band <= lastBand; ++band)
+  {
+    const int bandEnd = m_bandOffsets.at(band + 1);
+    for (int i = m_bandOffsets.at(band); i < bandEnd; ++i)
+    {
+      const int edge = m_bandEdges.at(i);
+
+      // the edge, in meters relative to the point
+      const double ax = (m_x1.at(edge) - lon) * metersPerDegreeLon;
+      const double ay = (m_y1.at(edge) - lat) * metersPerDegree;
+      const double dx = ((m_x2.at(edge) - lon) * metersPerDegreeLon) - ax;
+      const double dy = ((m_y2.at(edge) - lat) * metersPerDegree) - ay;
+
+      // the nearest point of the edge to the origin
+      const double lengthSquared = (dx * dx) + (dy * dy);
+      const double t = lengthSquared > 0.0 ? std::max(0.0, std::min(1.0, -((ax * dx) + (ay * dy)) / lengthSquared)) : 0.0;
+      const double x = ax + (t * dx);
+      const double y = ay + (t * dy);
+      nearestSquared = std::min(nearestSquared, (x * x) + (y * y));
+    }
+  }
+
+  return std::sqrt(nearestSquared);
+}
+
+/*!
+  \brief internal
+
+  Returns the index of the band which contains \a lat, clamped to the bands of the polygon.
+ */
+int PreparedPolygon::bandOf(double lat) const
+{
+  const int bandCount = m_bandOffsets.size() - 1;
+  const int band = static_cast<int>(std::floor((lat - m_yMin) / m_bandHeight));
+  return std::max(0, std::min(bandCount - 1, band));
+}
+
+} // Dsa
@@ -0,0 +1,80 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PREPAREDPOLYGON_H
+#define PREPAREDPOLYGON_H
+
+// dsa app headers
+#include "GeodesicUtils.h"
+
+// Qt headers
+#include <QVector>
+
+// STL headers
+#include <memory>
+
+namespace Esri {
+namespace ArcGISRuntime {
+  class Geometry;
+}
+}
+
+namespace Dsa {
+
+class PreparedPolygon
+{
+public:
+  static std::shared_ptr<const PreparedPolygon> create(const Esri::ArcGISRuntime::Geometry& wgs84Polygon);
+  static std::shared_ptr<const PreparedPolygon> create(const GeodesicUtils::PackedGeometry& wgs84Rings);
+
+  bool contains(double lon, double lat) const;
+  double boundaryDistance(double lon, double lat, double maxDistance) const;
+
+  int edgeCount() const;
+  double xMin() const { return m_xMin; }
+  double yMin() const { return m_yMin; }
+  double xMax() const { return m_xMax; }
+  double yMax() const { return m_yMax; }
+
+private:
+  PreparedPolygon() = default;
+
+  void build(const GeodesicUtils::PackedGeometry& wgs84Rings);
+  bool containsUnwrapped(double lon, double lat) const;
+  double boundaryDistanceUnwrapped(double lon, double lat, double maxDistance) const;
+  int bandOf(double lat) const;
+
+  // the edges of every ring, stored as packed arrays
+  QVector<double> m_x1;
+  QVector<double> m_y1;
+  QVector<double> m_x2;
+  QVector<double> m_y2;
+
+  // the edges overlapping each horizontal band of the extent: the edges of band b are
+  // m_bandEdges[m_bandOffsets[b]] to m_bandEdges[m_bandOffsets[b + 1] - 1]
+  QVector<int> m_bandOffsets;
+  QVector<int> m_bandEdges;
+  double m_bandHeight = 0.0;
+
+  double m_xMin = 0.0;
+  double m_yMin = 0.0;
+  double m_xMax = 0.0;
+  double m_yMax = 0.0;
+};
+
+} // Dsa
+
+#endif // PREPAREDPOLYGON_H
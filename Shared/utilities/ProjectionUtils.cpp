@@ -0,0 +1,239 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+// PCH header
+#include "pch.hpp"
+
+#include "ProjectionUtils.h"
+
+// C++ API headers
+#include "Envelope.h"
+#include "Geometry.h"
+#include "GeometryEngine.h"
+#include "Point.h"
+#include "SpatialReference.h"
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace Dsa {
+
+namespace
+{
+constexpr double Pi = 3.14159265358979323846;
+constexpr double DegreesToRadians = Pi / 180.0;
+
+// the latitude at which Web Mercator is square, beyond which it is clamped
+constexpr double MaxWebMercatorLatitude = 85.0511287798066;
+
+// how a geometry can be projected between two spatial references
+enum class Projection
+{
+  None,
+  ToWebMercator,
+  ToWgs84,
+  Other
+};
+
+Projection projectionBetween(const SpatialReference& from, const SpatialReference& to)
+{
+  if (from == to)
+    return Projection::None;
+
+  if (ProjectionUtils::isWgs84(from) && ProjectionUtils::isWebMercator(to))
+    return Projection::ToWebMercator;
+
+  if (ProjectionUtils::isWebMercator(from) && ProjectionUtils::isWgs84(to))
+    return Projection::ToWgs84;
+
+  return Projection::Other;
+}
+
+// projects a single coordinate using the closed-form equations
+void projectCoordinate(Projection projection, double x, double y, double& projectedX, double& projectedY)
+{
+  if (projection == Projection::ToWebMercator)
+    ProjectionUtils::wgs84ToWebMercator(&x, &y, 1, &projectedX, &projectedY);
+  else
+    ProjectionUtils::webMercatorToWgs84(&x, &y, 1, &projectedX, &projectedY);
+}
+}
+
+/*!
+  \namespace Dsa::ProjectionUtils
+  \inmodule Dsa
+  \brief Projection of coordinates and geometry, with a closed-form fast path between WGS84 and
+  Web Mercator.
+
+  Most of the geometry handled by the app is in WGS84 (e.g. from messages and the location
+  source) or Web Mercator (e.g. the basemap). Projecting between these two uses the spherical
+  Mercator equations directly, which can be applied to coordinate arrays and avoids a call to
+  \l Esri::ArcGISRuntime::GeometryEngine. Points and envelopes are projected this way; other
+  geometry, and other spatial references, are projected by the GeometryEngine.
+
+  Geometry which is already in the requested spatial reference is returned unchanged.
+ */
+
+/*!
+  \brief Returns whether \a spatialReference is WGS84 (WKID 4326).
+ */
+bool ProjectionUtils::isWgs84(const SpatialReference& spatialReference)
+{
+  return spatialReference.wkid() == 4326;
+}
+
+/*!
+  \brief Returns whether \a spatialReference is Web Mercator (WKID 3857, or one of its older WKIDs).
+ */
+bool ProjectionUtils::isWebMercator(const SpatialReference& spatialReference)
+{
+  switch (spatialReference.wkid())
+  {
+  case 3857:
+  case 102100:
+  case 102113:
+  case 900913:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/*!
+  \brief Projects \a count WGS84 coordinates in \a lons and \a lats (in decimal degrees) to
+  Web Mercator, writing the results to \a xs and \a ys (in meters).
+
+  Latitudes beyond the limits of Web Mercator (about 85 degrees) are clamped. The input and output
+  arrays can be the same.
+ */
+void ProjectionUtils::wgs84ToWebMercator(const double* lons, const double* lats, int count, double* xs, double* ys)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    const double lat = std::max(-MaxWebMercatorLatitude, std::min(MaxWebMercatorLatitude, lats[i]));
+    xs[i] = WebMercatorRadius * lons[i] * DegreesToRadians;
+    ys[i] = WebMercatorRadius * std::log(std::tan(Pi * 0.25 + lat * DegreesToRadians * 0.5));
+  }
+}
+
+/*!
+  \brief Projects \a count Web Mercator coordinates in \a xs and \a ys (in meters) to WGS84,
+  writing the results to \a lons and \a lats (in decimal degrees).
+
+  The input and output arrays can be the same.
+ */
+void ProjectionUtils::webMercatorToWgs84(const double* xs, const double* ys, int count, double* lons, double* lats)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    const double y = ys[i];
+    lons[i] = xs[i] / WebMercatorRadius / DegreesToRadians;
+    lats[i] = (2.0 * std::atan(std::exp(y / WebMercatorRadius)) - Pi * 0.5) / DegreesToRadians;
+  }
+}
+
+/*!
+  \brief Returns \a point projected to \a spatialReference.
+ */
+Point ProjectionUtils::project(const Point& point, const SpatialReference& spatialReference)
+{
+  if (point.isEmpty())
+    return point;
+
+  const Projection projection = projectionBetween(point.spatialReference(), spatialReference);
+  if (projection == Projection::None)
+    return point;
+
+  if (projection == Projection::Other || point.hasM())
+    return GeometryEngine::project(point, spatialReference);
+
+  double x = 0.0;
+  double y = 0.0;
+  projectCoordinate(projection, point.x(), point.y(), x, y);
+  return point.hasZ() ? Point(x, y, point.z(), spatialReference) : Point(x, y, spatialReference);
+}
+
+/*!
+  \brief Returns \a envelope projected to \a spatialReference.
+
+  Between WGS84 and Web Mercator each axis is projected independently and in order, so the
+  corners of the envelope project to the corners of the result.
+ */
+Envelope ProjectionUtils::project(const Envelope& envelope, const SpatialReference& spatialReference)
+{
+  if (envelope.isEmpty())
+    return envelope;
+
+  const Projection projection = projectionBetween(envelope.spatialReference(), spatialReference);
+  if (projection == Projection::None)
+    return envelope;
+
+  if (projection == Projection::Other || envelope.hasZ() || envelope.hasM())
+    return Envelope(GeometryEngine::project(envelope, spatialReference));
+
+  double xMin = 0.0;
+  double yMin = 0.0;
+  double xMax = 0.0;
+  double yMax = 0.0;
+  projectCoordinate(projection, envelope.xMin(), envelope.yMin(), xMin, yMin);
+  projectCoordinate(projection, envelope.xMax(), envelope.yMax(), xMax, yMax);
+  return Envelope(xMin, yMin, xMax, yMax, spatialReference);
+}
+
+/*!
+  \brief Returns \a geometry projected to \a spatialReference.
+
+  Points and envelopes use the fast path between WGS84 and Web Mercator. Any other geometry
+  which is not already in \a spatialReference is projected by the GeometryEngine.
+ */
+Geometry ProjectionUtils::project(const Geometry& geometry, const SpatialReference& spatialReference)
+{
+  if (geometry.isEmpty() || geometry.spatialReference() == spatialReference)
+    return geometry;
+
+  switch (geometry.geometryType())
+  {
+  case GeometryType::Point:
+    return project(Point(geometry), spatialReference);
+  case GeometryType::Envelope:
+    return project(Envelope(geometry), spatialReference);
+  default:
+    break;
+  }
+
+  return GeometryEngine::project(geometry, spatialReference);
+}
+
+/*!
+  \brief Returns \a point projected to WGS84.
+ */
+Point ProjectionUtils::toWgs84(const Point& point)
+{
+  return project(point, SpatialReference::wgs84());
+}
+
+/*!
+  \brief Returns \a geometry projected to WGS84.
+ */
+Geometry ProjectionUtils::toWgs84(const Geometry& geometry)
+{
+  return project(geometry, SpatialReference::wgs84());
+}
+
+} // Dsa
@@ -0,0 +1,52 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef PROJECTIONUTILS_H
+#define PROJECTIONUTILS_H
+
+namespace Esri {
+namespace ArcGISRuntime {
+  class Envelope;
+  class Geometry;
+  class Point;
+  class SpatialReference;
+}
+}
+
+namespace Dsa {
+
+namespace ProjectionUtils
+{
+  // the radius of the sphere used by Web Mercator, in meters
+  constexpr double WebMercatorRadius = 6378137.0;
+
+  bool isWgs84(const Esri::ArcGISRuntime::SpatialReference& spatialReference);
+  bool isWebMercator(const Esri::ArcGISRuntime::SpatialReference& spatialReference);
+
+  void wgs84ToWebMercator(const double* lons, const double* lats, int count, double* xs, double* ys);
+  void webMercatorToWgs84(const double* xs, const double* ys, int count, double* lons, double* lats);
+
+  Esri::ArcGISRuntime::Point project(const Esri::ArcGISRuntime::Point& point, const Esri::ArcGISRuntime::SpatialReference& spatialReference);
+  Esri::ArcGISRuntime::Envelope project(const Esri::ArcGISRuntime::Envelope& envelope, const Esri::ArcGISRuntime::SpatialReference& spatialReference);
+  Esri::ArcGISRuntime::Geometry project(const Esri::ArcGISRuntime::Geometry& geometry, const Esri::ArcGISRuntime::SpatialReference& spatialReference);
+
+  Esri::ArcGISRuntime::Point toWgs84(const Esri::ArcGISRuntime::Point& point);
+  Esri::ArcGISRuntime::Geometry toWgs84(const Esri::ArcGISRuntime::Geometry& geometry);
+}
+
+} // Dsa
+
+#endif // PROJECTIONUTILS_H
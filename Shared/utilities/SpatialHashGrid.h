@@ -0,0 +1,433 @@
+/*******************************************************************************
+ *  Copyright 2012-2018 Esri
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************/
+
+#ifndef SPATIALHASHGRID_H
+#define SPATIALHASHGRID_H
+
+// dsa app headers
+#include "GeodesicUtils.h"
+
+// Qt headers
+#include <QHash>
+#include <QVector>
+#include <QtGlobal>
+
+// STL headers
+#include <algorithm>
+#include <cmath>
+
+namespace Dsa {
+
+template <typename Id>
+class SpatialHashGrid
+{
+public:
+  explicit SpatialHashGrid(double cellSize = 1000.0);
+
+  double cellSize() const;
+  void setCellSize(double cellSize);
+
+  int count() const;
+  bool isEmpty() const;
+  bool contains(const Id& id) const;
+  void clear();
+
+  bool insert(const Id& id, double lon, double lat);
+  void remove(const Id& id);
+
+  template <typename Visitor>
+  void visitInBounds(double xMin, double yMin, double xMax, double yMax, Visitor&& visitor) const;
+
+  template <typename Visitor>
+  void visitNear(double xMin, double yMin, double xMax, double yMax, double distance, Visitor&& visitor) const;
+
+private:
+  struct Item
+  {
+    Id id;
+    double lon;
+    double lat;
+  };
+
+  struct Entry
+  {
+    quint64 cell = 0;
+    int slot = 0; // the index of the item in its cell
+  };
+
+  // the columns of a row which overlap a range of longitude
+  struct ColumnRange
+  {
+    int first = 0;
+    int count = 0; // columns from first, wrapping around the antimeridian
+  };
+
+  int rowOf(double lat) const;
+  int columnCount(int row) const;
+  ColumnRange columnRange(int row, double xMin, double xMax) const;
+  quint64 cellOf(double lon, double lat) const;
+  void removeFromCell(quint64 cell, int slot);
+
+  static quint64 cellKey(int row, int column);
+  static int columnOf(double lon, int columnCount);
+  static bool isInLonRange(double lon, double xMin, double xMax);
+
+  static constexpr double DegreesToRadians = 3.14159265358979323846 / 180.0;
+
+  double m_cellSize = 0.0; // in meters
+  double m_rowHeight = 0.0; // in degrees of latitude
+  int m_rowCount = 0;
+  QHash<quint64, QVector<Item>> m_cells;
+  QHash<Id, Entry> m_entries;
+};
+
+/*!
+  \class Dsa::SpatialHashGrid
+  \inmodule Dsa
+  \brief A set of WGS84 point locations, each identified by an \c Id, bucketed into a grid of cells
+  which are approximately \l cellSize meters across.
+
+  Cells are arranged in rows of equal height in latitude. Each row is divided into as many columns
+  as fit its width at the latitude furthest from the equator, so a cell is at least \l cellSize meters
+  across in both directions and columns wrap around the antimeridian. Only cells which contain a
+  location are stored.
+
+  When the cell size matches a search distance, the locations near to an area are found by visiting
+  only the neighbouring cells (\l visitNear). Moving a location with \l insert only touches its cells
+  if it has moved into a different cell.
+ */
+
+/*!
+  \brief Constructor taking the \a cellSize, in meters.
+ */
+template <typename Id>
+SpatialHashGrid<Id>::SpatialHashGrid(double cellSize)
+{
+  setCellSize(cellSize);
+}
+
+/*!
+  \brief Returns the minimum width and height of a cell, in meters.
+ */
+template <typename Id>
+double SpatialHashGrid<Id>::cellSize() const
+{
+  return m_cellSize;
+}
+
+/*!
+  \brief Sets the minimum width and height of a cell to \a cellSize meters.
+
+  Any locations in the grid are bucketed again.
+ */
+template <typename Id>
+void SpatialHashGrid<Id>::setCellSize(double cellSize)
+{
+  // a cell is at least a meter, and at most a single row, across
+  constexpr double metersPerDegree = GeodesicUtils::EarthRadius * DegreesToRadians;
+  const double size = std::max(1.0, cellSize);
+  if (size == m_cellSize)
+    return;
+
+  m_cellSize = size;
+  m_rowHeight = std::min(180.0, m_cellSize / metersPerDegree);
+  m_rowCount = std::max(1, static_cast<int>(std::ceil(180.0 / m_rowHeight)));
+
+  if (m_entries.isEmpty())
+    return;
+
+  QVector<Item> items;
+  items.reserve(m_entries.size());
+  for (const QVector<Item>& cellItems : qAsConst(m_cells))
+    items.append(cellItems);
+
+  clear();
+  for (const Item& item : qAsConst(items))
+    insert(item.id, item.lon, item.lat);
+}
+
+/*!
+  \brief Returns the number of locations in the grid.
+ */
+template <typename Id>
+int SpatialHashGrid<Id>::count() const
+{
+  return m_entries.size();
+}
+
+/*!
+  \brief Returns whether the grid contains no locations.
+ */
+template <typename Id>
+bool SpatialHashGrid<Id>::isEmpty() const
+{
+  return m_entries.isEmpty();
+}
+
+/*!
+  \brief Returns whether the grid has a location for \a id.
+ */
+template <typename Id>
+bool SpatialHashGrid<Id>::contains(const Id& id) const
+{
+  return m_entries.contains(id);
+}
+
+/*!
+  \brief Removes all locations from the grid.
+ */
+template <typename Id>
+void SpatialHashGrid<Id>::clear()
+{
+  m_cells.clear();
+  m_entries.clear();
+}
+
+/*!
+  \brief Sets the location of \a id to \a lon, \a lat (in WGS84 degrees).
+
+  If \a id is already in the grid, it is only moved to another cell if its new location is in one.
+  Returns \c true if the cell of \a id changed.
+ */
+template <typename Id>
+bool SpatialHashGrid<Id>::insert(const Id& id, double lon, double lat)
+{
+  const quint64 cell = cellOf(lon, lat);
+  auto findIt = m_entries.find(id);
+  if (findIt != m_entries.end())
+  {
+    Entry& entry = findIt.value();
+    if (entry.cell == cell)
+    {
+      Item& item = m_cells[cell][entry.slot];
+      item.lon = lon;
+      item.lat = lat;
+      return false;
+    }
+
+    removeFromCell(entry.cell, entry.slot);
+  }
+
+  QVector<Item>& cellItems = m_cells[cell];
+  Entry entry;
+  entry.cell = cell;
+  entry.slot = cellItems.size();
+  cellItems.append(Item{id, lon, lat});
+  m_entries.insert(id, entry);
+  return true;
+}
+
+/*!
+  \brief Removes the location of \a id from the grid.
+ */
+template <typename Id>
+void SpatialHashGrid<Id>::remove(const Id& id)
+{
+  auto findIt = m_entries.find(id);
+  if (findIt == m_entries.end())
+    return;
+
+  const Entry entry = findIt.value();
+  m_entries.erase(findIt);
+  removeFromCell(entry.cell, entry.slot);
+}
+
+/*!
+  \brief Calls \a visitor with the \c Id, longitude and latitude of each location within the WGS84 bounds
+  \a xMin, \a yMin, \a xMax, \a yMax.
+
+  The bounds can extend beyond the antimeridian (for example, an \a xMin of \c -190), in which case
+  locations on the other side of it are visited.
+
+  Only the cells which overlap the bounds are visited, unless there are more of them than there are
+  cells with locations, in which case each of those is tested instead.
+ */
+template <typename Id>
+template <typename Visitor>
+void SpatialHashGrid<Id>::visitInBounds(double xMin, double yMin, double xMax, double yMax, Visitor&& visitor) const
+{
+  yMin = std::max(-90.0, yMin);
+  yMax = std::min(90.0, yMax);
+  if (m_entries.isEmpty() || yMin > yMax || xMin > xMax)
+    return;
+
+  const int firstRow = rowOf(yMin);
+  const int lastRow = rowOf(yMax);
+
+  auto visitCell = [&](const QVector<Item>& cellItems)
+  {
+    for (const Item& item : cellItems)
+    {
+      if (item.lat >= yMin && item.lat <= yMax && isInLonRange(item.lon, xMin, xMax))
+        visitor(item.id, item.lon, item.lat);
+    }
+  };
+
+  // a large area is cheaper to search by testing the cells which have locations
+  qint64 overlapping = lastRow - firstRow + 1;
+  if (overlapping <= m_cells.size())
+  {
+    overlapping = 0;
+    for (int row = firstRow; row <= lastRow; ++row)
+      overlapping += columnRange(row, xMin, xMax).count;
+  }
+
+  if (overlapping > m_cells.size())
+  {
+    for (auto it = m_cells.cbegin(); it != m_cells.cend(); ++it)
+    {
+      const int row = static_cast<int>(it.key() >> 32);
+      if (row < firstRow || row > lastRow)
+        continue;
+
+      const int column = static_cast<int>(it.key() & 0xffffffff);
+      const ColumnRange range = columnRange(row, xMin, xMax);
+      const int offset = (column - range.first + columnCount(row)) % columnCount(row);
+      if (offset < range.count)
+        visitCell(it.value());
+    }
+
+    return;
+  }
+
+  for (int row = firstRow; row <= lastRow; ++row)
+  {
+    const int columns = columnCount(row);
+    const ColumnRange range = columnRange(row, xMin, xMax);
+    for (int i = 0; i < range.count; ++i)
+    {
+      auto findIt = m_cells.constFind(cellKey(row, (range.first + i) % columns));
+      if (findIt != m_cells.cend())
+        visitCell(findIt.value());
+    }
+  }
+}
+
+/*!
+  \brief Calls \a visitor with the \c Id, longitude and latitude of each location which could be
+  within \a distance meters of the WGS84 bounds \a xMin, \a yMin, \a xMax, \a yMax.
+
+  The bounds are extended by \a distance using \l GeodesicUtils::boundsForDistance, so locations
+  which are visited still need to be tested against the exact distance.
+
+  \sa visitInBounds
+ */
+template <typename Id>
+template <typename Visitor>
+void SpatialHashGrid<Id>::visitNear(double xMin, double yMin, double xMax, double yMax, double distance, Visitor&& visitor) const
+{
+  // longitude is extended the most at the corner furthest from the equator
+  const double poleward = std::abs(yMin) > std::abs(yMax) ? yMin : yMax;
+  double cornerXMin = 0.0;
+  double cornerYMin = 0.0;
+  double cornerXMax = 0.0;
+  double cornerYMax = 0.0;
+  GeodesicUtils::boundsForDistance(xMin, poleward, std::max(0.0, distance), cornerXMin, cornerYMin, cornerXMax, cornerYMax);
+
+  const double deltaLon = xMin - cornerXMin;
+  const double deltaLat = std::max(0.0, distance) / GeodesicUtils::EarthRadius / DegreesToRadians;
+  visitInBounds(xMin - deltaLon, yMin - deltaLat, xMax + deltaLon, yMax + deltaLat, std::forward<Visitor>(visitor));
+}
+
+template <typename Id>
+int SpatialHashGrid<Id>::rowOf(double lat) const
+{
+  const int row = static_cast<int>(std::floor((lat + 90.0) / m_rowHeight));
+  return std::max(0, std::min(m_rowCount - 1, row));
+}
+
+// the number of columns which are at least the cell size across at the poleward edge of the row
+template <typename Id>
+int SpatialHashGrid<Id>::columnCount(int row) const
+{
+  const double south = -90.0 + row * m_rowHeight;
+  const double north = std::min(90.0, south + m_rowHeight);
+  const double poleward = std::max(std::abs(south), std::abs(north));
+  const double width = 360.0 * std::cos(poleward * DegreesToRadians) / m_rowHeight;
+  return std::max(1, static_cast<int>(std::min(1.0e9, std::floor(width))));
+}
+
+template <typename Id>
+typename SpatialHashGrid<Id>::ColumnRange SpatialHashGrid<Id>::columnRange(int row, double xMin, double xMax) const
+{
+  const int columns = columnCount(row);
+  ColumnRange range;
+  if (xMax - xMin >= 360.0)
+  {
+    range.count = columns;
+    return range;
+  }
+
+  const double first = std::floor((xMin + 180.0) / 360.0 * columns);
+  const double last = std::floor((xMax + 180.0) / 360.0 * columns);
+  range.first = columnOf(xMin, columns);
+  range.count = static_cast<int>(std::min(static_cast<double>(columns), last - first + 1.0));
+  return range;
+}
+
+template <typename Id>
+quint64 SpatialHashGrid<Id>::cellOf(double lon, double lat) const
+{
+  const int row = rowOf(lat);
+  return cellKey(row, columnOf(lon, columnCount(row)));
+}
+
+// removes the item at slot from the cell, moving the last item of the cell into its place
+template <typename Id>
+void SpatialHashGrid<Id>::removeFromCell(quint64 cell, int slot)
+{
+  auto cellIt = m_cells.find(cell);
+  if (cellIt == m_cells.end())
+    return;
+
+  QVector<Item>& cellItems = cellIt.value();
+  const int lastSlot = cellItems.size() - 1;
+  if (slot != lastSlot)
+  {
+    cellItems[slot] = cellItems.at(lastSlot);
+    m_entries[cellItems.at(slot).id].slot = slot;
+  }
+
+  cellItems.removeLast();
+  if (cellItems.isEmpty())
+    m_cells.erase(cellIt);
+}
+
+template <typename Id>
+quint64 SpatialHashGrid<Id>::cellKey(int row, int column)
+{
+  return (static_cast<quint64>(row) << 32) | static_cast<quint32>(column);
+}
+
+// the column containing lon, wrapping longitudes beyond the antimeridian
+template <typename Id>
+int SpatialHashGrid<Id>::columnOf(double lon, int columnCount)
+{
+  const qint64 column = static_cast<qint64>(std::floor((lon + 180.0) / 360.0 * columnCount));
+  return static_cast<int>(((column % columnCount) + columnCount) % columnCount);
+}
+
+// whether lon, or lon shifted by a multiple of 360 degrees, lies between xMin and xMax
+template <typename Id>
+bool SpatialHashGrid<Id>::isInLonRange(double lon, double xMin, double xMax)
+{
+  const double shifted = lon + 360.0 * std::ceil((xMin - lon) / 360.0);
+  return shifted <= xMax;
+}
+
+} // Dsa
+
+#endif // SPATIALHASHGRID_H